@@ -0,0 +1,121 @@
+/**
+ * @file   crc_diff.c
+ * @brief  Differential test of the CRC-16/XMODEM kernels against the bit-serial reference.
+ *         The kernel is chosen at build time (YM_CRC_TABLE_SIZE, YM_CRC_SLICE, YM_CRC_CLMUL),
+ *         the Makefile builds this file once per kernel. Buffers are random in content, length
+ *         and alignment, and every one is also checked in two chained calls. ymodem_CheckCrcFxn
+ *         is run on a good and a broken provider right after ymodem_Init, before any packet.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "ymodem.h"
+
+#define CRC_DIFF_ROUNDS		(200000)
+#define CRC_DIFF_MAX_LEN	(4200)
+#define CRC_DIFF_MAX_ALIGN	(16)
+
+static uint8_t	buf[CRC_DIFF_MAX_LEN + CRC_DIFF_MAX_ALIGN];
+static uint32_t	seed = 0x1234567;
+
+static uint32_t Rand(void) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/**
+ * @brief  				Reference CRC-16/XMODEM, one bit at a time as in the original library.
+ */
+static uint16_t CrcBitSerial(uint16_t start, const uint8_t *data, uint32_t size) {
+	uint32_t crc = start;
+	uint8_t i;
+
+	while (size--) {
+		crc ^= (uint32_t)(*data++) << 8;
+		for (i = 0; i < 8; i++) {
+			crc <<= 1;
+			if (crc & 0x10000) {
+				crc ^= 0x1021;
+			}
+		}
+	}
+	return (uint16_t)crc;
+}
+
+static uint8_t SerialWrite(uint8_t *data, uint32_t len) {
+	(void)data;
+	(void)len;
+	return 0;
+}
+
+ymodem_err_e ymodem_FileCallback(ymodem_t *ymodem, ymodem_file_cb_e e, uint8_t *data, uint32_t len) {
+	(void)ymodem;
+	(void)e;
+	(void)data;
+	(void)len;
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Provider built on the reference, for ymodem_CheckCrcFxn.
+ */
+static uint16_t GoodCrc(void *ctx, uint16_t crc, const uint8_t *data, uint32_t len) {
+	(void)ctx;
+	return CrcBitSerial(crc, data, len);
+}
+
+/** Right for short calls, wrong once a call covers a whole 128 byte packet **/
+static uint16_t BadCrc(void *ctx, uint16_t crc, const uint8_t *data, uint32_t len) {
+	return (uint16_t)(GoodCrc(ctx, crc, data, len) ^ ((len >= 128) ? 1 : 0));
+}
+
+int main(void) {
+	static ymodem_t ymodem;
+	uint32_t round, i, len, align, split;
+	uint16_t ref, got;
+	uint32_t fails = 0;
+
+	ymodem_Init(&ymodem, SerialWrite);
+
+	/* Before any packet, so with zero-copy there is no packet buffer yet */
+	ymodem_SetCrcFxn(&ymodem, GoodCrc, NULL);
+	if (ymodem_CheckCrcFxn(&ymodem) != YMODEM_OK) {
+		printf("crc_diff: ymodem_CheckCrcFxn rejects a good provider\n");
+		fails++;
+	}
+	ymodem_SetCrcFxn(&ymodem, BadCrc, NULL);
+	if (ymodem_CheckCrcFxn(&ymodem) != YMODEM_CRC_ERR) {
+		printf("crc_diff: ymodem_CheckCrcFxn accepts a broken provider\n");
+		fails++;
+	}
+	ymodem_SetCrcFxn(&ymodem, NULL, NULL);
+
+	printf("crc_diff: table %d, slice %d, clmul %d", YM_CRC_TABLE_SIZE, YM_CRC_SLICE, YM_CRC_CLMUL);
+#if (YM_CRC_CLMUL > 0) && defined(__x86_64__) && defined(__GNUC__)
+	if (!__builtin_cpu_supports("pclmul") || !__builtin_cpu_supports("ssse3")) {
+		printf(" (no PCLMULQDQ on this CPU, the fallback is tested)");
+	}
+#endif
+	printf("\n");
+
+	for (round = 0; round < CRC_DIFF_ROUNDS; round++) {
+		/* Mostly packet sized buffers, some long ones to run the wide loops */
+		len = (round % 8 == 0) ? (Rand() % (CRC_DIFF_MAX_LEN + 1)) : (Rand() % 1030);
+		align = Rand() % CRC_DIFF_MAX_ALIGN;
+		for (i = 0; i < len; i++) {
+			buf[align + i] = (uint8_t)Rand();
+		}
+		ref = CrcBitSerial(0, buf + align, len);
+		got = ymodem_Crc16(NULL, 0, buf + align, len);
+		split = (len > 0) ? (Rand() % len) : 0;
+		if ((got != ref) ||
+			(ymodem_Crc16(NULL, ymodem_Crc16(NULL, 0, buf + align, split), buf + align + split, len - split) != ref)) {
+			if (fails++ < 10) {
+				printf("  mismatch: len %u align %u split %u, ref %04X got %04X\n",
+					   (unsigned)len, (unsigned)align, (unsigned)split, ref, got);
+			}
+		}
+	}
+
+	printf("crc_diff: %u buffers, %u mismatches\n", (unsigned)CRC_DIFF_ROUNDS, (unsigned)fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file   digest.c
+ * @brief  Known answers for ymodem_Crc32 and ymodem_Sha256*, one-shot and in chunks around the
+ *         64 byte block and the 55/56 byte padding boundary, then the file digest end to end over
+ *         the simulated line of link.c: given by the sender, checked by the receiver at the END.
+ *         The CRC-32 table follows YM_CRC_TABLE_SIZE, the Makefile builds this file once per size.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "link.h"
+
+#if (YM_DIGEST != (YM_DIGEST_CRC32 | YM_DIGEST_SHA256)) || (YM_RESUME == 0) || (YM_WINDOW < 8) || (YM_LZ == 0)
+#error "Build with YM_DIGEST=3, YM_RESUME=1, YM_WINDOW=8 and YM_LZ=1"
+#endif
+
+#define DIGEST_FILE_SIZE	(100000)
+/** Pattern of the chunked vectors, as the byte at i **/
+#define DIGEST_PATTERN(i)	((uint8_t)((i) * 7 + 3))
+
+typedef struct{
+	const char	*msg;
+	uint32_t	len;
+	const char	*sha256;
+} digest_kat_t;
+
+/* FIPS 180-2 examples, then the pattern around the padding and block boundaries */
+static const digest_kat_t shaKats[] = {
+	{ "", 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "abc", 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56,
+	  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 112,
+	  "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+	{ NULL, 55, "e7313d333c272e639f790978283f9eb392e843d0f29b7016828bb1daa4aac70b" },
+	{ NULL, 56, "4324d65f3c103567f5589c710bc08f8523f929a9272e3af36fc968e52abc6c27" },
+	{ NULL, 63, "81c80242132f230c3bd41b3e63bbcff16107339549214a99614ff26664625055" },
+	{ NULL, 64, "39e3d7b6b5d075d37d053ad89b24b41bef4f3c29760c84447cab3f3be1882241" },
+	{ NULL, 65, "aacca6ff74fdbb296d165a45cecfa04e5127bc008770fbbdd48006f2d2fae95e" },
+	{ NULL, 119, "9ce7368e4daf32341631b492e80359dc9f594b48453cd0dd5bf0b19279cc177e" },
+	{ NULL, 120, "7836b787757e95e58b3ca5aec90b1b004e8deba1e50e9675af9cabf1a13a04b5" },
+};
+
+static uint8_t	pattern[1000];
+static uint8_t	file[DIGEST_FILE_SIZE];
+static uint8_t	out[DIGEST_FILE_SIZE];
+static link_t	link;
+
+static void HexToBytes(const char *hex, uint8_t *bytes, uint32_t len) {
+	uint32_t i;
+	unsigned v;
+
+	for (i = 0; i < len; i++) {
+		sscanf(hex + 2 * i, "%2x", &v);
+		bytes[i] = (uint8_t)v;
+	}
+}
+
+/**
+ * @brief  				SHA-256 of data fed in two updates, split at split.
+ */
+static void Sha256Split(const uint8_t *data, uint32_t len, uint32_t split, uint8_t digest[32]) {
+	ymodem_sha256_t ctx;
+
+	ymodem_Sha256Init(&ctx);
+	ymodem_Sha256Update(&ctx, data, split);
+	ymodem_Sha256Update(&ctx, data + split, len - split);
+	ymodem_Sha256Final(&ctx, digest);
+}
+
+/**
+ * @brief  				Each vector one-shot, a byte at a time, and split in two at every offset.
+ */
+static int RunSha256Kats(void) {
+	const uint8_t *data;
+	uint8_t want[32], got[32];
+	ymodem_sha256_t ctx;
+	uint32_t i, split;
+	int fails = 0, fail;
+
+	for (i = 0; i < sizeof(shaKats) / sizeof(shaKats[0]); i++) {
+		data = (shaKats[i].msg != NULL) ? (const uint8_t *)shaKats[i].msg : pattern;
+		HexToBytes(shaKats[i].sha256, want, 32);
+		Sha256Split(data, shaKats[i].len, shaKats[i].len, got);
+		fail = (memcmp(got, want, 32) != 0);
+		ymodem_Sha256Init(&ctx);
+		for (split = 0; split < shaKats[i].len; split++) {
+			ymodem_Sha256Update(&ctx, data + split, 1);
+		}
+		ymodem_Sha256Final(&ctx, got);
+		fail |= (memcmp(got, want, 32) != 0);
+		for (split = 0; split <= shaKats[i].len; split++) {
+			Sha256Split(data, shaKats[i].len, split, got);
+			fail |= (memcmp(got, want, 32) != 0);
+		}
+		printf("  sha256    %3u bytes%s: %s\n", (unsigned)shaKats[i].len,
+			   (shaKats[i].msg != NULL) ? "" : " of pattern", fail ? "FAILED" : "ok");
+		fails += fail;
+	}
+	return fails;
+}
+
+/**
+ * @brief  				One million 'a', in chunks of 1 to 200 bytes that cross the blocks at every
+ * 						offset.
+ */
+static int RunSha256Million(void) {
+	uint8_t want[32], got[32];
+	ymodem_sha256_t ctx;
+	uint32_t done, n;
+	int fail;
+
+	memset(out, 'a', 200);
+	HexToBytes("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", want, 32);
+	ymodem_Sha256Init(&ctx);
+	for (done = 0, n = 1; done < 1000000; done += n, n = n % 200 + 1) {
+		if (n > 1000000 - done) {
+			n = 1000000 - done;
+		}
+		ymodem_Sha256Update(&ctx, out, n);
+	}
+	ymodem_Sha256Final(&ctx, got);
+	fail = (memcmp(got, want, 32) != 0);
+	printf("  sha256    1000000 'a' in chunks: %s\n", fail ? "FAILED" : "ok");
+	return fail;
+}
+
+/**
+ * @brief  				Check values, then the pattern chained in two calls at every split.
+ */
+static int RunCrc32Kats(void) {
+	static const char *fox = "The quick brown fox jumps over the lazy dog";
+	uint32_t split, crc;
+	int fail;
+
+	fail = (ymodem_Crc32(0, (const uint8_t *)"", 0) != 0x00000000) ||
+		   (ymodem_Crc32(0, (const uint8_t *)"123456789", 9) != 0xCBF43926) ||
+		   (ymodem_Crc32(0, (const uint8_t *)fox, (uint32_t)strlen(fox)) != 0x414FA339) ||
+		   (ymodem_Crc32(0, pattern, sizeof(pattern)) != 0x17BC2A46);
+	for (split = 0; split <= sizeof(pattern); split++) {
+		crc = ymodem_Crc32(ymodem_Crc32(0, pattern, split), pattern + split, sizeof(pattern) - split);
+		fail |= (crc != 0x17BC2A46);
+	}
+	printf("  crc32     check values, chained at every split: %s\n", fail ? "FAILED" : "ok");
+	return fail;
+}
+
+/**
+ * @brief  				A whole transfer with the digest given in block 0. The receiver's digest must be
+ * 						the one of the file, and digestStatus the one expected.
+ */
+static int RunLink(const char *mode, uint8_t digest, uint8_t flip, uint8_t window, uint8_t lzBits,
+				   uint32_t errPerMillion, uint32_t checkpoint, ymodem_digest_e want) {
+	static const char *statusName[] = { "none", "match", "mismatch" };
+	uint8_t sha[32];
+	ymodem_sha256_t ctx;
+	link_result_e result;
+	int fail;
+
+	memset(&link, 0, sizeof(link));
+	memset(out, 0, sizeof(out));
+	link.name = "image.bin";
+	link.file = file;
+	link.size = DIGEST_FILE_SIZE;
+	link.out = out;
+	link.delayUs = 5000;
+	link.window = window;
+	link.lzBits = lzBits;
+	link.errPerMillion = errPerMillion;
+	link.seed = 3;
+	link.digest = digest;
+	link.digestFlip = flip;
+	if (checkpoint > 0) {
+		/* As kept by an earlier session */
+		memcpy(out, file, checkpoint);
+		link.resume = 1;
+		link.checkpoint = checkpoint;
+	}
+	result = link_Run(&link);
+
+	/* What was delivered since the resume point, the rest was kept */
+	ymodem_Sha256Init(&ctx);
+	ymodem_Sha256Update(&ctx, file + link.resumedAt, DIGEST_FILE_SIZE - link.resumedAt);
+	ymodem_Sha256Final(&ctx, sha);
+	fail = (result != LINK_OK) || (link.rx.digestStatus != want) ||
+		   (link.rx.crc32 != ymodem_Crc32(0, file + link.resumedAt, DIGEST_FILE_SIZE - link.resumedAt)) ||
+		   (memcmp(link.rx.sha256, sha, 32) != 0) || ((checkpoint > 0) && (link.resumedAt == 0)) ||
+		   ((errPerMillion > 0) && (link.corrupted == 0));
+	printf("  link      %-22s: %s, resumed at %6u, digest %s (expected %s)%s\n", mode, link_ResultName(result),
+		   (unsigned)link.resumedAt, statusName[link.rx.digestStatus], statusName[want], fail ? ": FAILED" : "");
+	return fail;
+}
+
+int main(void) {
+	uint32_t i;
+	uint32_t seed = 0x2545F491;
+	int fails = 0;
+
+	for (i = 0; i < sizeof(pattern); i++) {
+		pattern[i] = DIGEST_PATTERN(i);
+	}
+	for (i = 0; i < sizeof(file); i++) {
+		seed = seed * 1103515245 + 12345;
+		file[i] = (i % 5 < 2) ? (uint8_t)(seed >> 16) : (uint8_t)(i >> 6);
+	}
+
+	printf("digest: CRC-32 table of %u entries\n", (unsigned)YM_CRC_TABLE_SIZE);
+	fails += RunCrc32Kats();
+	fails += RunSha256Kats();
+	fails += RunSha256Million();
+	fails += RunLink("1K", 1, 0, 0, 0, 0, 0, YMODEM_DIGEST_MATCH);
+	fails += RunLink("window 8, bit errors", 1, 0, 8, 0, 300, 0, YMODEM_DIGEST_MATCH);
+	fails += RunLink("LZ 12", 1, 0, 0, 12, 0, 0, YMODEM_DIGEST_MATCH);
+	fails += RunLink("no digest given", 0, 0, 0, 0, 0, 0, YMODEM_DIGEST_NONE);
+	fails += RunLink("wrong digest given", 1, 1, 0, 0, 0, 0, YMODEM_DIGEST_MISMATCH);
+	fails += RunLink("resumed", 1, 0, 0, 0, 0, 60000, YMODEM_DIGEST_NONE);
+
+	printf("digest: %d failures\n", fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
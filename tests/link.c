@@ -0,0 +1,370 @@
+/**
+ * @file   link.c
+ * @brief  Host loopback between the YMODEM sender and receiver, see link.h.
+ */
+#include <string.h>
+#include "link.h"
+
+/** Bytes a direction can hold in flight, more than a window of large blocks **/
+#define LINK_QUEUE_SIZE		(1u << 18)
+/** Receiver tick period **/
+#define LINK_TICK_US		(10000)
+/** Simulated time limit of a run **/
+#define LINK_LIMIT_US		(3600ull * 1000000ull)
+/** Control bytes seen on the line **/
+#define LINK_SOH			(0x01)
+#define LINK_STX			(0x02)
+#define LINK_NAK			(0x15)
+#define LINK_CA				(0x18)
+#define LINK_CRC16			(0x43)
+/** A burst of noise goes before one data packet in LINK_NOISE_EVERY **/
+#define LINK_NOISE_EVERY	(3)
+
+typedef struct{
+	uint8_t		data[LINK_QUEUE_SIZE];
+	uint64_t	arrival[LINK_QUEUE_SIZE];					/** Time the byte reaches the far end **/
+	uint32_t	head;										/** Next byte to deliver **/
+	uint32_t	tail;										/** Next free slot **/
+	uint64_t	busyUntil;									/** End of the last byte on the wire **/
+	uint32_t	errPerMillion;
+} link_queue_t;
+
+static link_queue_t toRx;
+static link_queue_t toTx;
+static link_t		*active;
+static link_file_t	single;									/** The file of a link without batch **/
+static link_file_t	*files;
+static uint32_t		fileCount;
+static uint32_t		rxFile;									/** File the receiver is on, ENDs so far **/
+static uint32_t		txFile;									/** File the sender is on **/
+static uint8_t		txStarting;								/** In ymodem_TxStart, which reads the file for its digest **/
+static uint64_t		nowUs;
+static uint64_t		byteUs;
+static uint32_t		seed;
+
+static uint32_t Rand(void) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+static void QueuePut(link_queue_t *q, const uint8_t *data, uint32_t len) {
+	uint32_t i;
+	uint8_t c;
+
+	for (i = 0; i < len; i++) {
+		c = data[i];
+		if ((q->errPerMillion > 0) && ((Rand() % 1000000u) < q->errPerMillion)) {
+			c ^= (uint8_t)(1u << (Rand() % 8));
+			active->corrupted++;
+		}
+		q->busyUntil = ((q->busyUntil > nowUs) ? q->busyUntil : nowUs) + byteUs;
+		q->data[q->tail % LINK_QUEUE_SIZE] = c;
+		q->arrival[q->tail % LINK_QUEUE_SIZE] = q->busyUntil + active->delayUs;
+		q->tail++;
+	}
+}
+
+static uint64_t QueueNext(const link_queue_t *q) {
+	return (q->head != q->tail) ? q->arrival[q->head % LINK_QUEUE_SIZE] : UINT64_MAX;
+}
+
+/**
+ * @brief  				Line noise as a terminal banner would make it: printable bytes, none of which
+ * 						can start a packet or abort ('A', 'a').
+ */
+static void QueueNoise(link_queue_t *q, uint32_t len) {
+	uint8_t c;
+
+	while (len--) {
+		do {
+			c = (uint8_t)(0x20 + Rand() % 0x5F);
+		} while ((c == 'A') || (c == 'a'));
+		QueuePut(q, &c, 1);
+	}
+}
+
+static uint8_t TxWrite(uint8_t *data, uint32_t len) {
+	/* Noise between packets: after the previous one, before a data packet */
+	if ((active->noiseSent < active->noiseBursts) && (len > 2) &&
+			((data[0] == LINK_SOH) || (data[0] == LINK_STX)) && (data[1] % LINK_NOISE_EVERY == 0)) {
+		QueueNoise(&toRx, active->noiseLen);
+		active->noiseSent++;
+	}
+	QueuePut(&toRx, data, len);
+	active->lineBytes += len;
+	return 0;
+}
+
+/**
+ * @brief  				Brings the receiver's clock up to the line before it runs, and the line up to the
+ * 						receiver's clock after: the time its work took holds up the bytes it sends.
+ */
+static void RxClockIn(void) {
+	if (active->rxClockUs != NULL) {
+		*active->rxClockUs = (uint32_t)nowUs;
+	}
+}
+
+static void RxClockOut(void) {
+	if ((active->rxClockUs != NULL) && (*active->rxClockUs > nowUs)) {
+		nowUs = *active->rxClockUs;
+	}
+}
+
+static uint8_t RxWrite(uint8_t *data, uint32_t len) {
+	uint32_t i;
+
+	RxClockOut();
+	if ((len > 0) && (data[0] == LINK_NAK)) {
+		active->naks++;
+	}
+	for (i = 0; i < len; i++) {
+		active->cancels += (data[i] == LINK_CA);
+	}
+	QueuePut(&toTx, data, len);
+	return 0;
+}
+
+ymodem_err_e ymodem_FileCallback(ymodem_t *ymodem, ymodem_file_cb_e e, uint8_t *data, uint32_t len) {
+	link_t *link = active;
+	link_file_t *f;
+
+	if ((rxFile >= fileCount) && ((e == YMODEM_FILE_CB_NAME) || (e == YMODEM_FILE_CB_DATA))) {
+		/* More files than were sent */
+		return YMODEM_SIZE_ERR;
+	}
+	f = &files[(rxFile < fileCount) ? rxFile : (fileCount - 1)];
+	switch (e) {
+		case YMODEM_FILE_CB_NAME:
+			if (strcmp((const char *)data, f->name) == 0) {
+				f->names++;
+			}
+			f->nameLen = len;
+#if (YM_RESUME > 0)
+			if (link->resume && (link->checkpoint > 0)) {
+				link->resumedAt = ymodem_Resume(ymodem, link->checkpoint);
+			}
+#endif
+			link->delivered = link->resumedAt;
+			break;
+		case YMODEM_FILE_CB_DATA:
+			if (ymodem->fileOffset + len > f->size) {
+				return YMODEM_SIZE_ERR;
+			}
+			memcpy(f->out + ymodem->fileOffset, data, len);
+			f->bytes += len;
+			link->delivered = ymodem->fileOffset + len;
+			break;
+		case YMODEM_FILE_CB_END:
+			f->ends++;
+			link->ends++;
+			rxFile++;
+			break;
+		default:
+			break;
+	}
+	if (link->onFile != NULL) {
+		return link->onFile(link->ctx, ymodem, e, data, len);
+	}
+	return YMODEM_OK;
+}
+
+uint32_t ymodem_TxReadCallback(ymodem_tx_t *tx, uint32_t offset, uint8_t *data, uint32_t len) {
+	const link_file_t *f = &files[txFile];
+
+	(void)tx;
+	if (offset > f->size) {
+		return 0;
+	}
+	if (len > f->size - offset) {
+		len = f->size - offset;
+	}
+	memcpy(data, f->file + offset, len);
+	if (txStarting && active->digestFlip && (offset == 0) && (len > 0)) {
+		data[0] ^= 0xFF;
+	}
+	return len;
+}
+
+static ymodem_err_e TxStart(const char *name, uint32_t size) {
+	ymodem_err_e ret;
+
+	txStarting = 1;
+	ret = ymodem_TxStart(&active->tx, name, size);
+	txStarting = 0;
+	return ret;
+}
+
+/**
+ * @brief  				Runs one session with fresh instances until both ends are done, the
+ * 						transfer is cut or the time limit is reached.
+ *
+ * @param  link			Link set up by the test, results filled in
+ * @return link_result_e
+ */
+link_result_e link_Run(link_t *link) {
+	ymodem_err_e rxRet = YMODEM_OK;
+	ymodem_err_e txRet = YMODEM_OK;
+	uint64_t nextTick = LINK_TICK_US;
+	ymodem_err_e ret;
+	uint64_t next, t;
+	uint8_t c;
+
+	active = link;
+	seed = link->seed;
+	nowUs = 0;
+	byteUs = 10000000ull / ((link->baud != 0) ? link->baud : 115200);
+	memset(&toRx, 0, sizeof(toRx));
+	memset(&toTx, 0, sizeof(toTx));
+	toRx.errPerMillion = link->errPerMillion;
+	toTx.errPerMillion = link->ackErrPerMillion;
+	link->delivered = 0;
+	link->resumedAt = 0;
+	link->ends = 0;
+	link->corrupted = 0;
+	link->lineBytes = 0;
+	link->noiseSent = 0;
+	link->naks = 0;
+	link->cancels = 0;
+	if (link->batch != NULL) {
+		files = link->batch;
+		fileCount = link->batchLen;
+	} else {
+		single.name = link->name;
+		single.file = link->file;
+		single.size = link->size;
+		single.out = link->out;
+		files = &single;
+		fileCount = 1;
+	}
+	for (rxFile = 0; rxFile < fileCount; rxFile++) {
+		files[rxFile].names = 0;
+		files[rxFile].nameLen = 0;
+		files[rxFile].bytes = 0;
+		files[rxFile].ends = 0;
+	}
+	rxFile = 0;
+	txFile = 0;
+
+	memset(&link->rx, 0, sizeof(link->rx));
+	memset(&link->tx, 0, sizeof(link->tx));
+	ymodem_Init(&link->rx, RxWrite);
+	ymodem_SetStreaming(&link->rx, link->streaming);
+	ymodem_TxInit(&link->tx, TxWrite);
+	ymodem_TxSetWindow(&link->tx, link->window);
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	ymodem_TxSetLargeBlocks(&link->tx, link->largeSize);
+#endif
+#if (YM_RESUME > 0)
+	ymodem_TxSetResume(&link->tx, link->resume);
+#endif
+#if (YM_LZ > 0)
+	ymodem_TxSetCompression(&link->tx, link->lzBits);
+#endif
+#if (YM_DIGEST > 0)
+	ymodem_TxSetDigest(&link->tx, link->digest);
+#endif
+	if (TxStart(files[0].name, files[0].size) != YMODEM_OK) {
+		return LINK_ABORTED;
+	}
+
+	while ((txRet != YMODEM_COMPLETE) || (rxRet != YMODEM_COMPLETE)) {
+		if ((link->cutAt > 0) && (link->delivered >= link->cutAt)) {
+			link->elapsedMs = (uint32_t)(nowUs / 1000);
+			return LINK_CUT;
+		}
+		if (((txRet == YMODEM_ABORTED) || (rxRet == YMODEM_ABORTED) || (rxRet == YMODEM_TIMEOUT)) &&
+				(toRx.head == toRx.tail) && (toTx.head == toTx.tail)) {
+			/* Once the line is empty, so the other end got the CA too */
+			link->elapsedMs = (uint32_t)(nowUs / 1000);
+			return LINK_ABORTED;
+		}
+		/* A streaming or windowed sender sends whenever its line is free */
+		if ((txRet != YMODEM_COMPLETE) && (toRx.busyUntil <= nowUs)) {
+			t = toRx.tail;
+			ret = ymodem_TxPoll(&link->tx);
+			if ((ret == YMODEM_COMPLETE) || (ret == YMODEM_ABORTED)) {
+				txRet = ret;
+			}
+			if (toRx.tail != t) {
+				continue;
+			}
+		}
+
+		next = nextTick;
+		if (QueueNext(&toRx) < next) {
+			next = QueueNext(&toRx);
+		}
+		if (QueueNext(&toTx) < next) {
+			next = QueueNext(&toTx);
+		}
+		if ((toRx.busyUntil > nowUs) && (toRx.busyUntil < next)) {
+			next = toRx.busyUntil;
+		}
+		if (next > nowUs) {
+			/* Otherwise behind a receiver that was busy, catching up */
+			nowUs = next;
+		}
+		if (nowUs > LINK_LIMIT_US) {
+			link->elapsedMs = (uint32_t)(nowUs / 1000);
+			return LINK_STALLED;
+		}
+
+		if (QueueNext(&toRx) == next) {
+			c = toRx.data[toRx.head++ % LINK_QUEUE_SIZE];
+			if (rxRet != YMODEM_COMPLETE) {
+				RxClockIn();
+				rxRet = ymodem_ReceiveByte(&link->rx, c);
+				RxClockOut();
+			}
+		} else if (QueueNext(&toTx) == next) {
+			c = toTx.data[toTx.head++ % LINK_QUEUE_SIZE];
+			if ((c == LINK_CRC16) && (rxFile > txFile) && (txFile + 1 < fileCount)) {
+				/* The EOT was ACKed and the receiver asks for block 0: the next file instead of
+				 * the empty block 0 */
+				txFile++;
+				if (TxStart(files[txFile].name, files[txFile].size) != YMODEM_OK) {
+					return LINK_ABORTED;
+				}
+			}
+			if (txRet != YMODEM_COMPLETE) {
+				txRet = ymodem_TxReceiveByte(&link->tx, c);
+			}
+		} else if (nextTick == next) {
+			nextTick += LINK_TICK_US;
+			if (rxRet != YMODEM_COMPLETE) {
+				RxClockIn();
+				rxRet = ymodem_Tick(&link->rx, LINK_TICK_US / 1000);
+				if (link->onTick != NULL) {
+					link->onTick(link->ctx);
+				}
+				RxClockOut();
+			}
+		}
+		while (nextTick < nowUs) {
+			/* The main loop did not run while the receiver was busy, its ticks are lost */
+			nextTick += LINK_TICK_US;
+		}
+	}
+
+	link->elapsedMs = (uint32_t)(nowUs / 1000);
+	if (link->ends != fileCount) {
+		return LINK_BAD_DATA;
+	}
+	for (txFile = 0; txFile < fileCount; txFile++) {
+		if ((files[txFile].ends != 1) || (memcmp(files[txFile].out, files[txFile].file, files[txFile].size) != 0)) {
+			return LINK_BAD_DATA;
+		}
+	}
+	return LINK_OK;
+}
+
+const char *link_ResultName(link_result_e result) {
+	switch (result) {
+		case LINK_OK:		return "ok";
+		case LINK_CUT:		return "cut";
+		case LINK_ABORTED:	return "aborted";
+		case LINK_STALLED:	return "stalled";
+		default:			return "bad data";
+	}
+}
@@ -0,0 +1,85 @@
+/**
+ * @file   link.h
+ * @brief  Host loopback between the YMODEM sender and receiver. Both directions are byte queues
+ *         with a baud rate, a one-way delay and optional random bit errors, driven by a simulated
+ *         clock. The receiver is ticked every 10 ms, so its timeouts and polls run as on a target.
+ */
+#ifndef LINK_H_
+#define LINK_H_
+
+#include "ymodem.h"
+
+#if (YM_SENDER == 0)
+#error "The loopback needs the sender, build with YM_SENDER=1"
+#endif
+
+typedef enum {
+	LINK_OK = 0,			/* Both ends completed, one END per file, files intact */
+	LINK_CUT,				/* Stopped once cutAt bytes were delivered, as a dropped line */
+	LINK_ABORTED,			/* One end aborted or cancelled, the line was left to drain */
+	LINK_STALLED,			/* Simulated time limit reached */
+	LINK_BAD_DATA,			/* Completed, but a file received differs or is missing */
+} link_result_e;
+
+/** One file of a batch **/
+typedef struct{
+	/* Set by the test */
+	const char		*name;									/** File name sent **/
+	const uint8_t	*file;									/** File contents **/
+	uint32_t		size;									/** Bytes of file **/
+	uint8_t			*out;									/** Receiver writes the file here by fileOffset, size bytes of room **/
+	/* Results */
+	uint32_t		names;									/** YMODEM_FILE_CB_NAME callbacks with this name **/
+	uint32_t		nameLen;								/** Size given with YMODEM_FILE_CB_NAME, from block 0 **/
+	uint32_t		bytes;									/** Bytes given by YMODEM_FILE_CB_DATA, in total **/
+	uint32_t		ends;									/** YMODEM_FILE_CB_END callbacks **/
+} link_file_t;
+
+typedef struct{
+	/* Set by the test */
+	const char		*name;									/** File name sent **/
+	const uint8_t	*file;									/** File contents **/
+	uint32_t		size;									/** Bytes of file **/
+	uint8_t			*out;									/** Receiver writes the file here by fileOffset, size bytes of room **/
+	link_file_t		*batch;									/** Files sent in one session instead of name/file/size/out, NULL if one **/
+	uint32_t		batchLen;								/** Files in batch **/
+	uint32_t		baud;									/** Line rate, 8N1, 115200 if 0 **/
+	uint32_t		delayUs;								/** One-way delay **/
+	uint32_t		errPerMillion;							/** Bytes with a flipped bit per million, sender to receiver **/
+	uint32_t		ackErrPerMillion;						/** Same, receiver to sender **/
+	uint32_t		seed;									/** Error pattern **/
+	uint32_t		noiseBursts;							/** Bursts of line noise put between data packets, toward the receiver **/
+	uint32_t		noiseLen;								/** Bytes per burst, printable and none that can start a packet **/
+	uint32_t		cutAt;									/** Stop once this many bytes were delivered, 0 to run to the end **/
+	uint8_t			window;									/** ymodem_TxSetWindow, YM_WINDOW builds **/
+	uint16_t		largeSize;								/** ymodem_TxSetLargeBlocks, large block builds **/
+	uint8_t			lzBits;									/** ymodem_TxSetCompression, YM_LZ builds **/
+	uint8_t			streaming;								/** YMODEM-G, ymodem_SetStreaming on the receiver **/
+	uint8_t			resume;									/** Offer resume and resume from checkpoint, YM_RESUME builds **/
+	uint32_t		checkpoint;								/** Bytes committed by an earlier session **/
+	uint8_t			digest;									/** ymodem_TxSetDigest, YM_DIGEST builds **/
+	uint8_t			digestFlip;								/** The sender reads its first byte flipped for the digest only, so the one given is wrong **/
+	/** Called after the file data is copied to out, e.g. a flash sink. NULL if unused **/
+	ymodem_err_e	(*onFile)(void *ctx, ymodem_t *ymodem, ymodem_file_cb_e e, uint8_t *data, uint32_t len);
+	/** Called at each receiver tick, as the application's main loop would, e.g. ymodem_SinkPoll. NULL if unused **/
+	void			(*onTick)(void *ctx);
+	void			*ctx;									/** Handed to onFile and onTick **/
+	uint32_t		*rxClockUs;								/** Clock the receiver's work moves on, e.g. a simulated flash, NULL if it takes no time **/
+	/* Results */
+	uint32_t		delivered;								/** End of the file data delivered so far **/
+	uint32_t		resumedAt;								/** Offset the receiver resumed from **/
+	uint32_t		ends;									/** YMODEM_FILE_CB_END callbacks, of all files **/
+	uint32_t		elapsedMs;								/** Simulated time **/
+	uint32_t		lineBytes;								/** Bytes the sender put on the line **/
+	uint32_t		corrupted;								/** Bytes damaged on the line **/
+	uint32_t		noiseSent;								/** Bursts of noise sent **/
+	uint32_t		naks;									/** Answers of the receiver that start with NAK **/
+	uint32_t		cancels;								/** CA bytes sent by the receiver **/
+	ymodem_t		rx;										/** Receiver, fresh for each link_Run **/
+	ymodem_tx_t		tx;										/** Sender, fresh for each link_Run **/
+} link_t;
+
+link_result_e	link_Run(link_t *link);
+const char		*link_ResultName(link_result_e result);
+
+#endif // LINK_H_
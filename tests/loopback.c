@@ -0,0 +1,204 @@
+/**
+ * @file   loopback.c
+ * @brief  Sender against receiver over the simulated line of link.c: files of every size around
+ *         the packet boundaries, then bit errors in either direction, then bursts of line noise
+ *         between packets, which may cost at most one NAK each. Last, a batch of files in one
+ *         session, which must end on the empty block 0. YMODEM-G against the ACKed protocol at
+ *         several line delays, and a YMODEM-G run with bit errors, which must end in a double CA.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "link.h"
+
+#define LOOPBACK_MAX_SIZE	(250000)
+
+static uint8_t file[LOOPBACK_MAX_SIZE];
+static uint8_t out[LOOPBACK_MAX_SIZE];
+static link_t  link;
+
+static int Run(uint32_t size, uint32_t errPerMillion, uint32_t ackErrPerMillion, uint32_t seed) {
+	link_result_e result;
+
+	memset(&link, 0, sizeof(link));
+	memset(out, 0, sizeof(out));
+	link.name = "loopback.bin";
+	link.file = file;
+	link.size = size;
+	link.out = out;
+	link.delayUs = 5000;
+	link.errPerMillion = errPerMillion;
+	link.ackErrPerMillion = ackErrPerMillion;
+	link.seed = seed;
+	result = link_Run(&link);
+	printf("  %6u bytes, errors %3u/%3u ppm, seed %u: %s, %u bytes damaged, %u.%03u s\n",
+		   (unsigned)size, (unsigned)errPerMillion, (unsigned)ackErrPerMillion, (unsigned)seed,
+		   link_ResultName(result), (unsigned)link.corrupted,
+		   (unsigned)(link.elapsedMs / 1000), (unsigned)(link.elapsedMs % 1000));
+	return (result == LINK_OK) ? 0 : 1;
+}
+
+static int RunNoise(uint32_t size, uint32_t bursts, uint32_t len, uint32_t seed) {
+	link_result_e result;
+	int fail;
+
+	memset(&link, 0, sizeof(link));
+	memset(out, 0, sizeof(out));
+	link.name = "noise.bin";
+	link.file = file;
+	link.size = size;
+	link.out = out;
+	link.delayUs = 5000;
+	link.noiseBursts = bursts;
+	link.noiseLen = len;
+	link.seed = seed;
+	result = link_Run(&link);
+	/* The first EOT is NAKed on a clean line too */
+	fail = (result != LINK_OK) || (link.noiseSent != bursts) || (link.naks > link.noiseSent + 1);
+	printf("  %6u bytes, %2u bursts of %3u bytes: %s, %u NAKs, %u.%03u s\n",
+		   (unsigned)size, (unsigned)link.noiseSent, (unsigned)len, link_ResultName(result),
+		   (unsigned)link.naks, (unsigned)(link.elapsedMs / 1000), (unsigned)(link.elapsedMs % 1000));
+	return fail;
+}
+
+/**
+ * @brief  				Several files in one session: a NAME, data cut to the size from block 0 and
+ * 						an END for each, in order, then completion on the empty block 0.
+ */
+static int RunBatch(void) {
+	static uint8_t outs[4][LOOPBACK_MAX_SIZE / 2];
+	link_file_t batch[4] = {
+		{ .name = "boot.bin",	.file = file,			.size = 3000,	.out = outs[0] },
+		{ .name = "app.bin",	.file = file + 3000,	.size = 100000,	.out = outs[1] },
+		{ .name = "empty.cfg",	.file = file,			.size = 0,		.out = outs[2] },
+		{ .name = "cert.pem",	.file = file + 7,		.size = 1025,	.out = outs[3] },
+	};
+	link_result_e result;
+	uint32_t i;
+	int fail;
+
+	memset(&link, 0, sizeof(link));
+	memset(outs, 0, sizeof(outs));
+	link.batch = batch;
+	link.batchLen = sizeof(batch) / sizeof(batch[0]);
+	link.delayUs = 5000;
+	link.seed = 8;
+	result = link_Run(&link);
+	fail = (result != LINK_OK) || (link.rx.filesReceived != link.batchLen) || (link.ends != link.batchLen);
+	printf("  %u files: %s, %u received, %u.%03u s\n", (unsigned)link.batchLen, link_ResultName(result),
+		   (unsigned)link.rx.filesReceived, (unsigned)(link.elapsedMs / 1000), (unsigned)(link.elapsedMs % 1000));
+	for (i = 0; i < link.batchLen; i++) {
+		if ((batch[i].names != 1) || (batch[i].nameLen != batch[i].size) || (batch[i].bytes != batch[i].size) ||
+				(batch[i].ends != 1)) {
+			fail = 1;
+		}
+		printf("    %-9s %6u bytes: NAME %u (size %u), DATA %u bytes, END %u\n", batch[i].name,
+			   (unsigned)batch[i].size, (unsigned)batch[i].names, (unsigned)batch[i].nameLen,
+			   (unsigned)batch[i].bytes, (unsigned)batch[i].ends);
+	}
+	return fail;
+}
+
+/**
+ * @brief  				One file with YMODEM-G or the ACKed protocol, on a clean line, elapsed time in ms.
+ */
+static uint32_t RunTimed(uint32_t size, uint8_t streaming, uint32_t delayUs, link_result_e *result) {
+	memset(&link, 0, sizeof(link));
+	memset(out, 0, sizeof(out));
+	link.name = "stream.bin";
+	link.file = file;
+	link.size = size;
+	link.out = out;
+	link.delayUs = delayUs;
+	link.streaming = streaming;
+	link.seed = 9;
+	*result = link_Run(&link);
+	return link.elapsedMs;
+}
+
+/**
+ * @brief  				Goodput of YMODEM-G and of the ACKed protocol as the line delay grows. Streaming
+ * 						must not wait for the round trip, so it must be faster at every delay.
+ */
+static int RunStreamGoodput(void) {
+	static const uint32_t delaysMs[] = { 0, 5, 20, 50 };
+	link_result_e acked, stream;
+	uint32_t i, ackedMs, streamMs;
+	int fails = 0;
+
+	for (i = 0; i < sizeof(delaysMs) / sizeof(delaysMs[0]); i++) {
+		ackedMs = RunTimed(LOOPBACK_MAX_SIZE, 0, delaysMs[i] * 1000, &acked);
+		streamMs = RunTimed(LOOPBACK_MAX_SIZE, 1, delaysMs[i] * 1000, &stream);
+		printf("  delay %2u ms: ACKed %s %5u B/s, YMODEM-G %s %5u B/s\n", (unsigned)delaysMs[i],
+			   link_ResultName(acked), (unsigned)(LOOPBACK_MAX_SIZE * 1000ull / ackedMs),
+			   link_ResultName(stream), (unsigned)(LOOPBACK_MAX_SIZE * 1000ull / streamMs));
+		fails += (acked != LINK_OK) || (stream != LINK_OK) || (streamMs >= ackedMs);
+	}
+	return fails;
+}
+
+/**
+ * @brief  				YMODEM-G does not retry: the first damaged packet makes the receiver cancel
+ * 						with a double CA, and the sender stops on it.
+ */
+static int RunStreamError(uint32_t errPerMillion, uint32_t seed) {
+	link_result_e result;
+	int fail;
+
+	memset(&link, 0, sizeof(link));
+	link.name = "stream.bin";
+	link.file = file;
+	link.size = LOOPBACK_MAX_SIZE;
+	link.out = out;
+	link.delayUs = 5000;
+	link.streaming = 1;
+	link.errPerMillion = errPerMillion;
+	link.seed = seed;
+	result = link_Run(&link);
+	fail = (result != LINK_ABORTED) || (link.cancels < 2) || (link.rx.nextStatus != YMODEM_ABORTED) ||
+		   (link.tx.nextStatus != YMODEM_ABORTED) || (link.delivered >= link.size);
+	printf("  errors %3u ppm, seed %u: %s at %u bytes, %u CA sent, sender %s\n", (unsigned)errPerMillion,
+		   (unsigned)seed, link_ResultName(result), (unsigned)link.delivered, (unsigned)link.cancels,
+		   (link.tx.nextStatus == YMODEM_ABORTED) ? "cancelled" : "NOT CANCELLED");
+	return fail;
+}
+
+int main(void) {
+	static const uint32_t sizes[] = { 0, 1, 127, 128, 129, 1023, 1024, 1025, 1152, 100000, 250000 };
+	uint32_t i;
+	uint32_t seed = 0x2545F491;
+	int fails = 0;
+
+	for (i = 0; i < sizeof(file); i++) {
+		seed = seed * 1103515245 + 12345;
+		/* Half random, half text-like, so padding bytes (0x1A) and zeros show up in the data */
+		file[i] = (i & 0x400) ? (uint8_t)(seed >> 16) : (uint8_t)("YMODEM \x1A\x00\n"[(seed >> 16) % 10]);
+	}
+
+	printf("loopback: clean line\n");
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		fails += Run(sizes[i], 0, 0, 1);
+	}
+	printf("loopback: bit errors\n");
+	fails += Run(250000, 200, 0, 1);
+	fails += Run(250000, 500, 0, 2);
+	fails += Run(250000, 0, 20000, 3);
+	fails += Run(100000, 300, 300, 4);
+
+	printf("loopback: line noise between packets\n");
+	fails += RunNoise(100000, 20, 100, 5);
+	fails += RunNoise(100000, 20, 1, 6);
+	/* Up to YM_PURGE_LIMIT bytes, a longer burst is NAKed once per YM_PURGE_LIMIT */
+	fails += RunNoise(250000, 60, 1000, 7);
+
+	printf("loopback: batch\n");
+	fails += RunBatch();
+
+	printf("loopback: YMODEM-G\n");
+	fails += RunStreamGoodput();
+	fails += RunStreamError(200, 10);
+	fails += RunStreamError(500, 11);
+
+	printf("loopback: %d failures\n", fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
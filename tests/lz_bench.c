@@ -0,0 +1,141 @@
+/**
+ * @file   lz_bench.c
+ * @brief  Goodput of the negotiated LZ compression over the simulated line of link.c, against
+ *         the same file sent as it is. Random data does not compress and must cost next to
+ *         nothing, an image shaped like an ELF file and an erased (zero) image must go faster.
+ *         Prints the compression ratio seen on the line and the goodput of each run.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "link.h"
+
+#if (YM_LZ == 0)
+#error "Build with YM_LZ=1"
+#endif
+
+#define BENCH_SIZE			(200000)
+/** LZ window offered, as in the commit that added compression **/
+#define BENCH_LZ_BITS		(10)
+
+static uint8_t	file[BENCH_SIZE];
+static uint8_t	out[BENCH_SIZE];
+static link_t	link;
+static uint32_t	seed = 0x2545F491;
+
+static uint32_t Rand(void) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+static void FillRandom(uint8_t *data, uint32_t size) {
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		data[i] = (uint8_t)Rand();
+	}
+}
+
+/**
+ * @brief  				Something like a firmware ELF: code made of a small set of opcodes with
+ * 						random operands, a string table, a symbol table of fixed size records and
+ * 						zero padding between the sections.
+ */
+static void FillElf(uint8_t *data, uint32_t size) {
+	static const char *words[] = { "error", "flash", "init", "uart", "timer", "_handler", "config",
+								   "ymodem", "buffer", "status", "%s: %d\n", "task", "irq", "dma_" };
+	uint32_t opcodes[32];
+	uint32_t i, n, op;
+	const char *w;
+
+	for (i = 0; i < 32; i++) {
+		opcodes[i] = Rand();
+	}
+	i = 0;
+	while (i < size) {
+		switch ((i / 4096) % 8) {
+			case 0: case 1: case 2: case 3:
+				/* Code: a frequent opcode, its low byte an operand now and then */
+				op = opcodes[(Rand() % 32) & (Rand() % 32)];
+				if (Rand() % 4 == 0) {
+					op = (op & ~0xFFu) | (Rand() & 0xFF);
+				}
+				for (n = 0; (n < 4) && (i < size); n++) {
+					data[i++] = (uint8_t)(op >> (8 * n));
+				}
+				break;
+			case 4:
+				/* String table */
+				w = words[Rand() % (sizeof(words) / sizeof(words[0]))];
+				while (*w && (i < size)) {
+					data[i++] = (uint8_t)*w++;
+				}
+				if (i < size) {
+					data[i++] = 0;
+				}
+				break;
+			case 5: case 6:
+				/* Symbol table: address, size, info, section */
+				op = 0x08000000 + (i & ~0xFu) * 3;
+				for (n = 0; (n < 16) && (i < size); n++) {
+					data[i++] = (n < 4) ? (uint8_t)(op >> (8 * n)) : ((n == 4) ? (uint8_t)Rand() : ((n == 12) ? 0x12 : 0));
+				}
+				break;
+			default:
+				/* Alignment padding */
+				data[i++] = 0;
+				break;
+		}
+	}
+}
+
+static uint32_t Run(const uint8_t *data, uint8_t lzBits, uint32_t *lineBytes, link_result_e *result) {
+	memset(&link, 0, sizeof(link));
+	memset(out, 0, sizeof(out));
+	link.name = "image.bin";
+	link.file = data;
+	link.size = BENCH_SIZE;
+	link.out = out;
+	link.delayUs = 5000;
+	link.lzBits = lzBits;
+	link.seed = 1;
+	*result = link_Run(&link);
+	*lineBytes = link.lineBytes;
+	return link.elapsedMs;
+}
+
+/**
+ * @brief  				The file sent as it is and compressed. minGain is the speedup compression must
+ * 						reach, in percent of the time without it.
+ */
+static int Bench(const char *name, uint32_t minGain) {
+	link_result_e plain, lz;
+	uint32_t plainMs, lzMs, plainBytes, lzBytes;
+	int fail;
+
+	plainMs = Run(file, 0, &plainBytes, &plain);
+	lzMs = Run(file, BENCH_LZ_BITS, &lzBytes, &lz);
+	fail = (plain != LINK_OK) || (lz != LINK_OK) || (lzMs * 100 > plainMs * minGain);
+	printf("  %-7s ratio %4u.%02u: plain %s %5u B/s, lz %u %s %5u B/s (%3u%% of the time, at most %u%%)\n",
+		   name, (unsigned)(plainBytes / lzBytes), (unsigned)(plainBytes * 100ull / lzBytes % 100),
+		   link_ResultName(plain), (unsigned)(BENCH_SIZE * 1000ull / plainMs), BENCH_LZ_BITS,
+		   link_ResultName(lz), (unsigned)(BENCH_SIZE * 1000ull / lzMs), (unsigned)(lzMs * 100 / plainMs),
+		   (unsigned)minGain);
+	return fail;
+}
+
+int main(void) {
+	int fails = 0;
+
+	printf("lz_bench: %u bytes, window %u bits\n", (unsigned)BENCH_SIZE, BENCH_LZ_BITS);
+	FillRandom(file, BENCH_SIZE);
+	fails += Bench("random", 102);
+	FillElf(file, BENCH_SIZE);
+	fails += Bench("elf", 80);
+	/* A packet carries at most YM_LZ_INPUT bytes of file, 4 packets' worth by default */
+	memset(file, 0, BENCH_SIZE);
+	fails += Bench("zero", 30);
+
+	printf("lz_bench: %d failures\n", fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
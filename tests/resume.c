@@ -0,0 +1,93 @@
+/**
+ * @file   resume.c
+ * @brief  End-to-end resume over the simulated line of link.c: a first session is cut once 90%
+ *         of the file was delivered, a second one with fresh instances resumes from the bytes
+ *         committed, and the file must come out whole. Classic, window and large block modes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "link.h"
+
+#if (YM_RESUME == 0) || (YM_WINDOW < 8) || (YM_PACKET_MAX_SIZE < 8192)
+#error "Build with YM_RESUME=1, YM_WINDOW=8 and YM_PACKET_MAX_SIZE=8192"
+#endif
+
+#define RESUME_SIZE		(2000000)
+
+static uint8_t file[RESUME_SIZE];
+static uint8_t out[RESUME_SIZE];
+static link_t  link;
+
+static void Setup(uint8_t window, uint16_t largeSize, uint32_t errPerMillion, uint32_t seed) {
+	memset(&link, 0, sizeof(link));
+	link.name = "firmware.bin";
+	link.file = file;
+	link.size = RESUME_SIZE;
+	link.out = out;
+	link.delayUs = 5000;
+	link.window = window;
+	link.largeSize = largeSize;
+	link.errPerMillion = errPerMillion;
+	link.seed = seed;
+	link.resume = 1;
+}
+
+/**
+ * @brief  				Cuts a transfer at cutPercent and resumes it from the bytes delivered.
+ * 						Whatever the application had not committed is overwritten first, so
+ * 						the second session has to send it again.
+ */
+static int Run(const char *mode, uint8_t window, uint16_t largeSize, uint32_t cutPercent, uint32_t errPerMillion) {
+	link_result_e first, second;
+	uint32_t checkpoint, firstMs;
+
+	memset(out, 0, sizeof(out));
+	Setup(window, largeSize, errPerMillion, 1);
+	link.cutAt = (uint32_t)((uint64_t)RESUME_SIZE * cutPercent / 100);
+	first = link_Run(&link);
+	checkpoint = link.delivered;
+	firstMs = link.elapsedMs;
+	memset(out + checkpoint, 0xEE, RESUME_SIZE - checkpoint);
+
+	Setup(window, largeSize, errPerMillion, 2);
+	link.checkpoint = checkpoint;
+	second = link_Run(&link);
+
+	printf("  %-10s cut at %3u%%: session 1 %s at %7u bytes after %u.%03u s, session 2 resumed at %7u, "
+		   "%s after %u.%03u s\n", mode, (unsigned)cutPercent,
+		   link_ResultName(first), (unsigned)checkpoint, (unsigned)(firstMs / 1000), (unsigned)(firstMs % 1000),
+		   (unsigned)link.resumedAt, link_ResultName(second),
+		   (unsigned)(link.elapsedMs / 1000), (unsigned)(link.elapsedMs % 1000));
+	if ((first != LINK_CUT) || (second != LINK_OK)) {
+		return 1;
+	}
+	/* From a 1K boundary just before the checkpoint, moved back at most by a window */
+	if ((link.resumedAt > checkpoint) || (link.resumedAt % YM_PACKET_1K_SIZE != 0) ||
+		(checkpoint - link.resumedAt > (YM_WINDOW + 1) * YM_PACKET_1K_SIZE)) {
+		printf("  resume offset %u is wrong for checkpoint %u\n", (unsigned)link.resumedAt, (unsigned)checkpoint);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void) {
+	uint32_t i;
+	uint32_t seed = 0x2545F491;
+	int fails = 0;
+
+	for (i = 0; i < sizeof(file); i++) {
+		seed = seed * 1103515245 + 12345;
+		file[i] = (uint8_t)(seed >> 16);
+	}
+
+	printf("resume: %u byte file, 115200 baud\n", (unsigned)RESUME_SIZE);
+	fails += Run("classic", 0, 0, 90, 0);
+	fails += Run("window 8", 8, 0, 90, 0);
+	fails += Run("8K blocks", 0, 8192, 90, 0);
+	fails += Run("classic", 0, 0, 90, 200);
+	fails += Run("window 8", 8, 0, 50, 200);
+
+	printf("resume: %d failures\n", fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,374 @@
+/**
+ * @file   sink_sim.c
+ * @brief  Transfers over the simulated line of link.c into the flash sink, on the simulated flash.
+ *         Counts the program and erase operations per image against ceil(size / page) and
+ *         ceil(size / sector), checks the flash contents, and the rollback and resume on abort.
+ *         With compare-before-write, an older image is in flash first: only the sectors that
+ *         differ may be erased, by the transfer and by its rollback. With erase and program
+ *         times, the line time moves the flash clock on, and erasing ahead of the data must
+ *         take the erases out of the stall of erasing in the callback.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "link.h"
+#include "ymodem_sink.h"
+
+#if (YM_SINK_SIM == 0) || (YM_RESUME == 0) || (YM_LZ == 0) || (YM_PACKET_MAX_SIZE < 8192)
+#error "Build with YM_SINK_SIM=1, YM_RESUME=1, YM_LZ=1 and YM_PACKET_MAX_SIZE=8192"
+#endif
+
+#define SIM_FLASH_BASE		(0x08000000)
+#define SIM_FLASH_SIZE		(1u << 20)
+/** Sink region inside the simulated flash, aligned for every sector size tested **/
+#define SIM_REGION			(0x08020000)
+#define SIM_REGION_SIZE		(512u * 1024u)
+/** Written outside the region, must survive every test **/
+#define SIM_SENTINEL		(0x5A)
+#define SIM_FILE_SIZE		(300000)
+/** Time to program a page, with timing **/
+#define SIM_PROGRAM_US		(500)
+/** A 1K packet on the line at 115200 8N1, with its header and CRC **/
+#define SIM_PACKET_US		(1029u * 10u * 1000000u / 115200u)
+
+typedef struct{
+	ymodem_flashsim_t	sim;
+	ymodem_sink_t		sink;
+	uint32_t			resumeFrom;							/** sink->committed of an earlier transfer, 0 if none **/
+} sim_ctx_t;
+
+static uint8_t	mem[SIM_FLASH_SIZE];
+static uint8_t	page[128u * 1024u];
+static uint8_t	sector[128u * 1024u];
+static uint8_t	old[SIM_FILE_SIZE];
+static uint8_t	file[SIM_FILE_SIZE];
+static uint8_t	out[SIM_FILE_SIZE];
+static link_t	link;
+static sim_ctx_t sim;
+
+static ymodem_err_e SinkFile(void *ctx, ymodem_t *ymodem, ymodem_file_cb_e e, uint8_t *data, uint32_t len) {
+	sim_ctx_t *s = (sim_ctx_t *)ctx;
+	ymodem_err_e ret;
+
+	ret = ymodem_SinkCallback(&s->sink, ymodem, e, data, len);
+	if ((ret == YMODEM_OK) && (e == YMODEM_FILE_CB_NAME) && (s->resumeFrom > 0)) {
+		link.resumedAt = ymodem_SinkResume(&s->sink, ymodem, s->resumeFrom);
+	}
+	return ret;
+}
+
+static void SinkTick(void *ctx) {
+	sim_ctx_t *s = (sim_ctx_t *)ctx;
+
+	/* The main loop polls as well, next to ymodem_Tick */
+	ymodem_SinkPoll(&s->sink);
+}
+
+static void SinkSetup(uint32_t pageSize, uint32_t sectorSize) {
+	ymodem_sink_ops_t ops;
+
+	ymodem_FlashSimOps(&sim.sim, &ops);
+	ymodem_SinkInit(&sim.sink, &ops, page, pageSize, sectorSize);
+	ymodem_SinkSetRegion(&sim.sink, SIM_REGION, SIM_REGION_SIZE);
+	sim.resumeFrom = 0;
+}
+
+static void SimSetup(uint32_t pageSize, uint32_t sectorSize) {
+	memset(&sim, 0, sizeof(sim));
+	ymodem_FlashSimInit(&sim.sim, mem, SIM_FLASH_BASE, SIM_FLASH_SIZE, pageSize, sectorSize);
+	memset(mem, SIM_SENTINEL, SIM_REGION - SIM_FLASH_BASE);
+	memset(mem + (SIM_REGION - SIM_FLASH_BASE) + SIM_REGION_SIZE, SIM_SENTINEL,
+		   SIM_FLASH_SIZE - (SIM_REGION - SIM_FLASH_BASE) - SIM_REGION_SIZE);
+	SinkSetup(pageSize, sectorSize);
+}
+
+static void LinkSetup(uint16_t largeSize, uint8_t lzBits, uint32_t cutAt) {
+	memset(&link, 0, sizeof(link));
+	link.name = "image.bin";
+	link.file = file;
+	link.size = SIM_FILE_SIZE;
+	link.out = out;
+	link.delayUs = 5000;
+	link.largeSize = largeSize;
+	link.lzBits = lzBits;
+	link.resume = 1;
+	link.cutAt = cutAt;
+	link.seed = 1;
+	link.onFile = SinkFile;
+	link.onTick = SinkTick;
+	link.ctx = &sim;
+	link.rxClockUs = &sim.sim.nowUs;
+}
+
+static uint8_t IsFilled(uint32_t from, uint32_t to, uint8_t value) {
+	uint32_t i;
+
+	for (i = from; i < to; i++) {
+		if (mem[i - SIM_FLASH_BASE] != value) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static uint8_t SentinelsIntact(void) {
+	return IsFilled(SIM_FLASH_BASE, SIM_REGION, SIM_SENTINEL) &&
+		   IsFilled(SIM_REGION + SIM_REGION_SIZE, SIM_FLASH_BASE + SIM_FLASH_SIZE, SIM_SENTINEL);
+}
+
+/**
+ * @brief  				The image, then erased bytes up to the end of its last sector.
+ */
+static uint8_t ImageIntact(uint32_t sectorSize) {
+	uint32_t end = SIM_REGION + ((SIM_FILE_SIZE + sectorSize - 1) / sectorSize) * sectorSize;
+
+	return (memcmp(mem + (SIM_REGION - SIM_FLASH_BASE), file, SIM_FILE_SIZE) == 0) &&
+		   IsFilled(SIM_REGION + SIM_FILE_SIZE, end, YM_SINK_ERASED) && SentinelsIntact();
+}
+
+/**
+ * @brief  				A whole image: one program per page and one erase per sector.
+ */
+static int RunImage(const char *mode, uint32_t pageSize, uint32_t sectorSize, uint16_t largeSize, uint8_t lzBits) {
+	uint32_t pages = (SIM_FILE_SIZE + pageSize - 1) / pageSize;
+	uint32_t sectors = (SIM_FILE_SIZE + sectorSize - 1) / sectorSize;
+	link_result_e result;
+	int fail;
+
+	SimSetup(pageSize, sectorSize);
+	LinkSetup(largeSize, lzBits, 0);
+	result = link_Run(&link);
+	fail = (result != LINK_OK) || (sim.sim.programOps != pages) || (sim.sink.programOps != pages) ||
+		   (sim.sim.eraseOps != sectors) || (sim.sim.errors != 0) || (sim.sim.flushOps != 1) ||
+		   !ImageIntact(sectorSize);
+	printf("  %-9s page %6u sector %6u: %s, programOps %u (ceil %u), eraseOps %u (ceil %u), errors %u, flash %s\n",
+		   mode, (unsigned)pageSize, (unsigned)sectorSize, link_ResultName(result),
+		   (unsigned)sim.sim.programOps, (unsigned)pages, (unsigned)sim.sim.eraseOps, (unsigned)sectors,
+		   (unsigned)sim.sim.errors, ImageIntact(sectorSize) ? "intact" : "DIFFERS");
+	return fail;
+}
+
+/**
+ * @brief  				Cut half way: the sink rolls back every sector it wrote. With eraseUs, the erases
+ * 						take time and run in the background, one ahead of the data: the rollback waits
+ * 						for the one running and erases the sector erased ahead as well.
+ */
+static int RunRollback(uint32_t pageSize, uint32_t sectorSize, uint32_t eraseUs) {
+	link_result_e result;
+	ymodem_err_e ret;
+	int fail;
+
+	SimSetup(pageSize, sectorSize);
+	if (eraseUs > 0) {
+		ymodem_FlashSimSetTiming(&sim.sim, eraseUs, SIM_PROGRAM_US, 1, 0);
+		SinkSetup(pageSize, sectorSize);
+	}
+	/* What an earlier image left in the region */
+	memset(mem + (SIM_REGION - SIM_FLASH_BASE), 0x00, SIM_REGION_SIZE);
+	LinkSetup(0, 0, SIM_FILE_SIZE / 2);
+	result = link_Run(&link);
+	ret = ymodem_SinkAbort(&sim.sink);
+	/* Every sector from the first one the file erased is erased, the rest is left alone */
+	fail = (result != LINK_CUT) || (ret != YMODEM_OK) || (sim.sim.errors != 0) ||
+		   (sim.sink.eraseFrom != SIM_REGION) || (sim.sink.committed != 0) || (sim.sink.erasing != 0) ||
+		   !IsFilled(SIM_REGION, SIM_REGION + (SIM_FILE_SIZE / 2), YM_SINK_ERASED) ||
+		   !IsFilled(SIM_REGION + SIM_FILE_SIZE, SIM_REGION + SIM_REGION_SIZE, 0x00) || !SentinelsIntact();
+	printf("  rollback  page %6u sector %6u erase %4u ms: %s at %u bytes, abort %s, errors %u, written sectors %s\n",
+		   (unsigned)pageSize, (unsigned)sectorSize, (unsigned)(eraseUs / 1000), link_ResultName(result),
+		   (unsigned)link.delivered, (ret == YMODEM_OK) ? "ok" : "failed", (unsigned)sim.sim.errors,
+		   fail ? "NOT ERASED" : "erased");
+	return fail;
+}
+
+/**
+ * @brief  				Cut at 90% with keep-on-abort, then resumed from sink->committed: no page is
+ * 						programmed twice and the image comes out whole.
+ */
+static int RunResume(uint32_t pageSize, uint32_t sectorSize, uint8_t lzBits) {
+	uint32_t pages = (SIM_FILE_SIZE + pageSize - 1) / pageSize;
+	link_result_e first, second;
+	uint32_t committed;
+	int fail;
+
+	SimSetup(pageSize, sectorSize);
+	ymodem_SinkSetKeepOnAbort(&sim.sink, 1);
+	LinkSetup(0, lzBits, SIM_FILE_SIZE / 10 * 9);
+	first = link_Run(&link);
+	ymodem_SinkAbort(&sim.sink);
+	committed = sim.sink.committed;
+
+	/* As after a reset: a new sink, the checkpoint kept by the application */
+	SinkSetup(pageSize, sectorSize);
+	ymodem_SinkSetKeepOnAbort(&sim.sink, 1);
+	sim.resumeFrom = committed;
+	LinkSetup(0, lzBits, 0);
+	second = link_Run(&link);
+	/* The page the cut left open is programmed in two parts, all others once */
+	fail = (first != LINK_CUT) || (second != LINK_OK) || (link.resumedAt == 0) || (sim.sim.errors != 0) ||
+		   (sim.sim.programOps > pages + 1) || !ImageIntact(sectorSize);
+	printf("  resume    page %6u sector %6u: cut at %u, committed %u, resumed at %u: %s, programOps %u "
+		   "(ceil %u), errors %u, flash %s\n", (unsigned)pageSize, (unsigned)sectorSize,
+		   (unsigned)(SIM_FILE_SIZE / 10 * 9), (unsigned)committed, (unsigned)link.resumedAt,
+		   link_ResultName(second), (unsigned)sim.sim.programOps, (unsigned)pages, (unsigned)sim.sim.errors,
+		   ImageIntact(sectorSize) ? "intact" : "DIFFERS");
+	return fail;
+}
+
+/**
+ * @brief  				Puts an older image in the region: the file with one byte changed in each of the
+ * 						sectors given, as programmed by an earlier transfer.
+ */
+static void OldImage(uint32_t sectorSize, const uint32_t *changed, uint32_t nChanged) {
+	uint32_t i;
+
+	memcpy(old, file, SIM_FILE_SIZE);
+	for (i = 0; i < nChanged; i++) {
+		old[changed[i] * sectorSize + 100] ^= 0xA5;
+	}
+	memcpy(mem + (SIM_REGION - SIM_FLASH_BASE), old, SIM_FILE_SIZE);
+}
+
+/**
+ * @brief  				Compare-before-write over an older image: a whole transfer erases and programs only
+ * 						the sectors that differ, a transfer cut half way and aborted erases only the ones
+ * 						it rewrote, from the first to the last. The changed sectors are in the first half.
+ */
+static int RunCompare(uint32_t pageSize, uint32_t sectorSize, const uint32_t *changed, uint32_t nChanged) {
+	uint32_t sectors = (SIM_FILE_SIZE + sectorSize - 1) / sectorSize;
+	uint32_t first = SIM_REGION, last = SIM_REGION;
+	link_result_e result;
+	ymodem_err_e ret;
+	int fail;
+
+	SimSetup(pageSize, sectorSize);
+	ymodem_SinkSetCompare(&sim.sink, sector);
+	OldImage(sectorSize, changed, nChanged);
+	LinkSetup(0, 0, 0);
+	result = link_Run(&link);
+	fail = (result != LINK_OK) || (sim.sink.comparedSectors != sectors) ||
+		   (sim.sink.skippedSectors != sectors - nChanged) || (sim.sim.eraseOps != nChanged) ||
+		   (sim.sim.errors != 0) || !ImageIntact(sectorSize);
+	printf("  compare   page %6u sector %6u: %u sectors differ: %s, skipped %u/%u, eraseOps %u, programOps %u, "
+		   "errors %u, flash %s\n", (unsigned)pageSize, (unsigned)sectorSize, (unsigned)nChanged,
+		   link_ResultName(result), (unsigned)sim.sink.skippedSectors, (unsigned)sim.sink.comparedSectors,
+		   (unsigned)sim.sim.eraseOps, (unsigned)sim.sim.programOps, (unsigned)sim.sim.errors,
+		   ImageIntact(sectorSize) ? "intact" : "DIFFERS");
+
+	SimSetup(pageSize, sectorSize);
+	ymodem_SinkSetCompare(&sim.sink, sector);
+	OldImage(sectorSize, changed, nChanged);
+	LinkSetup(0, 0, SIM_FILE_SIZE / 2);
+	result = link_Run(&link);
+	ret = ymodem_SinkAbort(&sim.sink);
+	if (nChanged > 0) {
+		first = SIM_REGION + changed[0] * sectorSize;
+		last = SIM_REGION + (changed[nChanged - 1] + 1) * sectorSize;
+	}
+	/* Rewritten sectors erased, the older image everywhere else */
+	fail |= (result != LINK_CUT) || (ret != YMODEM_OK) || (sim.sim.errors != 0) ||
+			(sim.sim.eraseOps != nChanged + (last - first) / sectorSize) ||
+			(memcmp(mem + (SIM_REGION - SIM_FLASH_BASE), old, first - SIM_REGION) != 0) ||
+			!IsFilled(first, last, YM_SINK_ERASED) ||
+			(memcmp(mem + (last - SIM_FLASH_BASE), old + (last - SIM_REGION), SIM_FILE_SIZE - (last - SIM_REGION)) != 0) ||
+			!SentinelsIntact();
+	printf("  compare   page %6u sector %6u: %u sectors differ: %s at %u bytes, abort erased %u sectors, "
+		   "rest of the older image %s\n", (unsigned)pageSize, (unsigned)sectorSize, (unsigned)nChanged,
+		   link_ResultName(result), (unsigned)link.delivered, (unsigned)(sim.sim.eraseOps - nChanged),
+		   fail ? "CHANGED" : "kept");
+	return fail;
+}
+
+/**
+ * @brief  				One image with erase and program times, 256 byte pages.
+ *
+ * @param  background	0 to erase in the callback, 1 to erase ahead of the data
+ * @param  concurrent	1 if other sectors can be programmed during an erase
+ */
+static int RunTimed(uint32_t sectorSize, uint32_t eraseUs, uint8_t background, uint8_t concurrent) {
+	uint32_t sectors = (SIM_FILE_SIZE + sectorSize - 1) / sectorSize;
+	link_result_e result;
+
+	SimSetup(256, sectorSize);
+	ymodem_FlashSimSetTiming(&sim.sim, eraseUs, SIM_PROGRAM_US, background, concurrent);
+	SinkSetup(256, sectorSize);
+	LinkSetup(0, 0, 0);
+	result = link_Run(&link);
+	return (result != LINK_OK) || (sim.sim.eraseOps != sectors) || (sim.sim.errors != 0) ||
+		   (sim.sim.flushOps != 1) || !ImageIntact(sectorSize);
+}
+
+/**
+ * @brief  				Erasing in the callback against erasing ahead, single bank and concurrent: each
+ * 						writes the image whole, and erasing ahead stalls less. An erase shorter than a
+ * 						packet on the line is hidden nearly completely. One shorter than a sector on the
+ * 						line is hidden when programming goes on during it, but for the first erase,
+ * 						which only has the gap before the first packet.
+ */
+static int RunEraseAhead(uint32_t sectorSize, uint32_t eraseUs) {
+	uint32_t syncMs, syncWaitUs, aheadMs, aheadWaitUs, concMs, concWaitUs;
+	int fail;
+
+	fail = RunTimed(sectorSize, eraseUs, 0, 0);
+	syncMs = link.elapsedMs;
+	syncWaitUs = sim.sim.eraseWaitUs;
+	fail |= RunTimed(sectorSize, eraseUs, 1, 0);
+	aheadMs = link.elapsedMs;
+	aheadWaitUs = sim.sim.eraseWaitUs;
+	fail |= RunTimed(sectorSize, eraseUs, 1, 1);
+	concMs = link.elapsedMs;
+	concWaitUs = sim.sim.eraseWaitUs;
+	fail |= (aheadWaitUs >= syncWaitUs) || (concWaitUs > aheadWaitUs) || (aheadMs >= syncMs) || (concMs > aheadMs);
+	if (eraseUs < SIM_PACKET_US) {
+		fail |= (aheadWaitUs > syncWaitUs / 10);
+	}
+	if (eraseUs < sectorSize / YM_PACKET_1K_SIZE * SIM_PACKET_US) {
+		fail |= (concWaitUs > eraseUs);
+	}
+	printf("  erase     sector %6u erase %4u ms: in the callback %u ms (%u ms stalled), ahead %u ms (%u ms), "
+		   "concurrent %u ms (%u ms)%s\n", (unsigned)sectorSize, (unsigned)(eraseUs / 1000),
+		   (unsigned)syncMs, (unsigned)(syncWaitUs / 1000), (unsigned)aheadMs, (unsigned)(aheadWaitUs / 1000),
+		   (unsigned)concMs, (unsigned)(concWaitUs / 1000), fail ? ": FAILED" : "");
+	return fail;
+}
+
+int main(void) {
+	uint32_t i;
+	uint32_t seed = 0x2545F491;
+	int fails = 0;
+
+	for (i = 0; i < sizeof(file); i++) {
+		seed = seed * 1103515245 + 12345;
+		/* Compressible, so LZ packets carry pieces of every size */
+		file[i] = (i % 7 < 3) ? (uint8_t)(seed >> 16) : (uint8_t)(i >> 5);
+	}
+
+	printf("sink_sim: %u byte image\n", (unsigned)SIM_FILE_SIZE);
+	fails += RunImage("1K", 256, 4096, 0, 0);
+	fails += RunImage("1K", 2048, 16384, 0, 0);
+	fails += RunImage("LZ 12", 256, 4096, 0, 12);
+	fails += RunImage("LZ 12", 2048, 16384, 0, 12);
+	fails += RunImage("8K", 8192, 65536, 8192, 0);
+	fails += RunImage("8K", 131072, 131072, 8192, 0);
+	fails += RunRollback(256, 4096, 0);
+	fails += RunRollback(2048, 16384, 0);
+	fails += RunRollback(256, 4096, 50000);
+	fails += RunRollback(256, 65536, 500000);
+	fails += RunResume(256, 4096, 12);
+	fails += RunResume(2048, 16384, 0);
+	{
+		static const uint32_t changed[] = { 3, 6 };
+
+		fails += RunCompare(256, 4096, changed, 0);
+		fails += RunCompare(256, 4096, changed, 2);
+		fails += RunCompare(2048, 16384, changed, 1);
+	}
+	fails += RunTimed(4096, 0, 0, 0);
+	printf("  erase     sector   4096 erase    0 ms: %u ms\n", (unsigned)link.elapsedMs);
+	fails += RunEraseAhead(4096, 50000);
+	fails += RunEraseAhead(4096, 400000);
+	fails += RunEraseAhead(65536, 500000);
+	fails += RunEraseAhead(65536, 1000000);
+
+	printf("sink_sim: %d failures\n", fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
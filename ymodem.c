@@ -11,6 +11,13 @@
  */
 #include "ymodem.h"
 
+#if (YM_CRC_CLMUL > 0) && defined(__x86_64__) && defined(__GNUC__)
+#define YM_CRC_CLMUL_ENABLED	(1)
+#include <immintrin.h>
+#else
+#define YM_CRC_CLMUL_ENABLED	(0)
+#endif
+
 
 /**
  * @brief  YMODEM Control Characters
@@ -19,20 +26,45 @@
 enum YM_CC {
 	SOH			= 0x01,	 /* start of 128-byte data packet */
 	STX			= 0x02,  /* start of 1024-byte data packet */
+	STX_LARGE	= 0x03,  /* start of a large data packet, of the size agreed in block 0 */
 	EOT			= 0x04,  /* end of transmission */
 	ACK			= 0x06,  /* acknowledge */
 	NAK			= 0x15,  /* negative acknowledge */
 	CA			= 0x18,  /* two of these in succession aborts transfer */
+	CPMEOF		= 0x1A,  /* pads the last data packet of a file */
 	CRC16		= 0x43,  /* 'C' == 0x43, request 16-bit CRC */
+	CRCG		= 0x47,  /* 'G' == 0x47, request streaming without ACKs (YMODEM-G) */
 	ABORT1		= 0x41,  /* 'A' == 0x41, abort by user */
 	ABORT2		= 0x61,  /* 'a' == 0x61, abort by user */
 };
 
 
-/** Polynomial for CRC calculation **/
-#define YM_CRC_POLY		(0x1021)
+/** Values of ymodem_t resync **/
+#define YM_SYNC_NONE	(0)		/* Receiving normally */
+#define YM_SYNC_HEADER	(1)		/* Discarding a packet with a broken header */
+#define YM_SYNC_PURGE	(2)		/* Discarding line noise between packets */
+
+/** Block 0 extension, after the NUL that ends the file size field: the marker, a byte of
+ *  capabilities, then the parameters of each capability in bit order. The receiver answers
+ *  ACK, the marker, the capabilities it accepts with their parameters, and 'C' **/
+#define YM_EXT_MARKER	('@')
+#define YM_CAP_WINDOW	(0x01)	/* 1 byte, packets in flight. ACK/NAK carry a sequence number */
+#define YM_CAP_LARGE	(0x02)	/* 1 byte, large block size in KB. Those packets start with STX_LARGE */
+#define YM_CAP_RESUME	(0x04)	/* Offered without a parameter. Answered with the resume offset in KB,
+								 * YM_RESUME_DIGITS decimal digits and a check digit */
+#define YM_CAP_LZ		(0x08)	/* 1 byte, LZ window bits. Data packets carry compressed file data */
+#define YM_CAP_DIGEST	(0x10)	/* Not answered. 1 byte of YM_DIGEST_* bits, then the CRC-32 of the file
+								 * (4 bytes, little endian) and its SHA-256 (32 bytes), the ones given */
+#define YM_RESUME_DIGITS	(7)		/* Up to 4G of the 32 bit file size in KB */
+
+/** Compressed data packets start with a 16 bit little endian count of the bytes that follow,
+ *  the rest is padding. With YM_LZ_STORED the bytes are file data as it is, otherwise they are
+ *  LZ tokens: a flag byte, then 8 items, a literal byte (flag bit 0) or a match (flag bit 1) of
+ *  16 bits, little endian: distance - 1 in the low window bits, length - YM_LZ_MIN_MATCH above.
+ *  The history carries on from one packet to the next, for the whole file **/
+#define YM_LZ_STORED		(0x8000)
+#define YM_LZ_MIN_MATCH		(3)
 
-#define SWAP16(x)		(x >> 8) | ((x & 0xff) << 8)
 #define ISVALIDDEC(c) 	((c >= '0') && (c <= '9'))
 #define CONVERTDEC(c)	(c - '0')
 
@@ -51,8 +83,29 @@ typedef enum {
 	YM_RX_OK,		/* Data receive ok, return ACK */
 	YM_RX_COMPLETE,	/* Data receive complete, return ACK */
 	YM_SUCCESS,		/* Transfer complete, close */
+	YM_HELD,		/* Response held, return nothing until released */
+	YM_TIMEOUT,		/* Retry limit or session timeout, return 2x CA */
 } ym_ret_t;
 
+#if (YM_SENDER > 0)
+/**
+ * @brief  Sender states
+ * 
+ */
+typedef enum {
+	YM_TX_IDLE = 0,			/* No file, waiting for ymodem_TxStart */
+	YM_TX_WAIT_START,		/* Block 0 built, waiting for 'C' */
+	YM_TX_WAIT_NAME_ACK,	/* Block 0 sent, waiting for ACK */
+	YM_TX_WAIT_DATA_C,		/* Block 0 ACKed, waiting for 'C' before the data */
+	YM_TX_WAIT_DATA_ACK,	/* Data packet sent, waiting for ACK */
+	YM_TX_STREAM,			/* YMODEM-G, data packets go out from ymodem_TxPoll */
+	YM_TX_WINDOW,			/* Window agreed, packets go out from ymodem_TxPoll, ACK/NAK carry a sequence */
+	YM_TX_WAIT_EOT_ACK,		/* EOT sent, waiting for ACK */
+	YM_TX_WAIT_END_C,		/* EOT ACKed, waiting for 'C' before the empty block 0 */
+	YM_TX_WAIT_END_ACK,		/* Empty block 0 sent, waiting for ACK */
+} ym_tx_state_t;
+#endif
+
 
 
 
@@ -60,10 +113,74 @@ ymodem_err_e 	ymodem_Abort(ymodem_t *ymodem);
 static ym_ret_t ymodem_ProcessPacket(ymodem_t *ymodem);
 static ym_ret_t ymodem_ProcessFirstPacket(ymodem_t *ymodem);
 static ym_ret_t ymodem_ProcessDataPacket(ymodem_t *ymodem);
+static uint32_t ymodem_DataLength(ymodem_t *ymodem, uint16_t size);
+static ym_ret_t ymodem_ProcessEot(ymodem_t *ymodem);
+static void		ymodem_ParseExtensions(ymodem_t *ymodem, const uint8_t *ext, const uint8_t *end);
+#if (YM_WINDOW > 0)
+static ym_ret_t ymodem_ProcessWindowPacket(ymodem_t *ymodem);
+static void		ymodem_ResetWindow(ymodem_t *ymodem);
+#endif
+static void		ymodem_ExtAnswer(ymodem_t *ymodem);
+static int32_t	ymodem_FirstPacket(ymodem_t *ymodem);
+static uint16_t	ymodem_RetryLimit(ymodem_t *ymodem);
+#if (YM_RESUME > 0)
+static uint8_t	ymodem_ResumeCheck(uint32_t kb);
+#endif
+#if (YM_LZ > 0)
+static ym_ret_t ymodem_LzDeliver(ymodem_t *ymodem, const uint8_t *data, uint16_t size);
+static ym_ret_t ymodem_LzFlush(ymodem_t *ymodem, uint16_t start, uint16_t end);
+#endif
+#if (YM_DIGEST > 0)
+static void		ymodem_DigestStart(ymodem_t *ymodem);
+static void		ymodem_DigestUpdate(ymodem_t *ymodem, const uint8_t *data, uint32_t len);
+static void		ymodem_DigestFinish(ymodem_t *ymodem);
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+static void		ymodem_Sha256Block(ymodem_sha256_t *ctx, const uint8_t *block);
+#endif
 static ym_ret_t ymodem_CheckCRC(ymodem_t *ymodem);
 static void 	ymodem_WriteSerial(ymodem_t *ymodem);
+static ymodem_err_e ymodem_Respond(ymodem_t *ymodem, ym_ret_t ret);
+static ymodem_err_e ymodem_ReleaseHeld(ymodem_t *ymodem);
+static ym_ret_t ymodem_StartPacket(ymodem_t *ymodem, uint16_t size);
+static ym_ret_t ymodem_StartPurge(ymodem_t *ymodem, uint8_t c);
+static ym_ret_t ymodem_Resync(ymodem_t *ymodem, uint8_t c);
+static uint16_t ymodem_HeaderSize(ymodem_t *ymodem, uint8_t c);
+#if (YM_ZERO_COPY > 0)
+static uint8_t *ymodem_PopBuffer(ymodem_t *ymodem);
+#if (YM_DOUBLE_BUFFER > 0)
+static void		ymodem_ReclaimBuffers(ymodem_t *ymodem);
+static uint8_t	ymodem_BufferBit(ymodem_t *ymodem, uint8_t *buf);
+#endif
+#endif
+#if (YM_SENDER > 0)
+static ymodem_err_e ymodem_TxSend(ymodem_tx_t *tx);
+static ymodem_err_e ymodem_TxRetry(ymodem_tx_t *tx);
+static ymodem_err_e ymodem_TxNextPacket(ymodem_tx_t *tx);
+static ymodem_err_e ymodem_TxLoadPacket(ymodem_tx_t *tx, uint32_t offset, uint8_t seq);
+static uint32_t	ymodem_TxPackets(ymodem_tx_t *tx);
+static ymodem_err_e ymodem_TxWindowSend(ymodem_tx_t *tx, uint32_t pkt);
+static uint8_t	ymodem_TxWindowByte(ymodem_tx_t *tx, uint8_t c);
+static ymodem_err_e ymodem_TxWindowAnswer(ymodem_tx_t *tx, uint8_t cmd, uint8_t seq);
+static void		ymodem_TxBuildPacket(ymodem_tx_t *tx, uint16_t size);
+static uint8_t	ymodem_TxOffer(ymodem_tx_t *tx);
+static uint8_t	ymodem_TxExtParam(ymodem_tx_t *tx, uint8_t c);
+static void		ymodem_TxExtReset(ymodem_tx_t *tx);
+#if (YM_DIGEST > 0)
+static uint8_t	*ymodem_TxDigest(ymodem_tx_t *tx, uint8_t *ext);
+#endif
+#if (YM_LZ > 0)
+static ymodem_err_e ymodem_TxLzLoadPacket(ymodem_tx_t *tx, uint32_t offset, uint8_t seq);
+static uint16_t ymodem_TxLzEncode(ymodem_tx_t *tx, uint32_t inLen, uint8_t *out, uint16_t cap, uint32_t *consumed);
+static void		ymodem_TxLzSlide(ymodem_tx_t *tx, uint32_t consumed);
+#endif
+#endif
 
 static uint32_t Str2Int(uint8_t *inputstr, uint32_t *intnum);
+static uint8_t	*Str2Oct(uint8_t *inputstr, uint8_t *end, uint32_t *intnum);
+static uint16_t Swap16(uint16_t val);
+static uint16_t crc16Sw(uint16_t crc, const uint8_t *data, uint32_t size);
+static uint16_t ymodem_CrcUpdate(ymodem_t *ymodem, uint16_t crc, const uint8_t *data, uint32_t len);
 
 
 /**
@@ -79,16 +196,65 @@ void ymodem_Init(ymodem_t *ymodem, ymodem_fxn_t SerialWriteFxn) {
 
 	memset(ymodem->fileName, 	0, YM_FILE_NAME_LENGTH);
 	memset(ymodem->fileSizeStr, 0, YM_FILE_SIZE_LENGTH);
-	memset(ymodem->packetData, 	0, YM_PACKET_1K_OVRHD_SIZE);
+#if (YM_ZERO_COPY > 0)
+	ymodem->packetData		= NULL;
+	ymodem->bufHead			= 0;
+	ymodem->bufCount		= 0;
+#else
+	memset(ymodem->packetData, 	0, YM_PACKET_MAX_OVRHD_SIZE);
+#endif
 	ymodem->fileSize 		= 0;
+	ymodem->fileSizeKnown	= 0;
+	ymodem->fileMtime		= 0;
+	ymodem->fileMode		= 0;
+	ymodem->fileSerial		= 0;
+	ymodem->fileOffset		= 0;
 	ymodem->prevC 			= 0;
 	ymodem->startOfPacket 	= 1;
 	ymodem->packetBytes 	= 0;
 	ymodem->packetSize 		= 0;
 	ymodem->packetsReceived	= 0;
 	ymodem->eotReceived 	= 0;
+	ymodem->filesReceived	= 0;
+#if (YM_CRC_INCREMENTAL > 0)
+	ymodem->crc 			= 0;
+#endif
+	ymodem->txHeld			= 0;
+	ymodem->cbPending		= 0;
+	ymodem->resync			= YM_SYNC_NONE;
+	ymodem->discardLeft		= 0;
+	ymodem->streaming		= 0;
+	ymodem->extCaps			= 0;
+	ymodem->retries			= 0;
+	ymodem->retryPkt		= 0;
+	ymodem->duplicates		= 0;
+	ymodem->idleMs			= 0;
+	ymodem->sessionMs		= 0;
+#if (YM_WINDOW > 0)
+	ymodem_ResetWindow(ymodem);
+#endif
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	ymodem->largeSize		= 0;
+#endif
+#if (YM_RESUME > 0)
+	ymodem->resumeOk		= 0;
+	ymodem->resumeAt		= 0;
+#endif
+#if (YM_LZ > 0)
+	ymodem->lzBits			= 0;
+	ymodem->lzPos			= 0;
+#endif
+#if (YM_DIGEST > 0)
+	ymodem->digestGiven		= 0;
+	ymodem_DigestStart(ymodem);
+#endif
+	ymodem->crcFxn			= NULL;
+	ymodem->crcCtx			= NULL;
 	ymodem->serialWriteFxn 	= SerialWriteFxn;
 	ymodem->nextStatus 		= YMODEM_OK;
+#if (YM_DOUBLE_BUFFER > 0)
+	ymodem_ReclaimBuffers(ymodem);
+#endif
 	ymodem->initialized 	= YM_INSTANCE_INIT_MASK;
 }
 
@@ -125,26 +291,86 @@ static ymodem_err_e GenerateResponse(ymodem_t *ymodem, ym_ret_t retVal) {
 			ymodem_Abort(ymodem);
 			ymodem->nextStatus = YMODEM_SIZE_ERR;
 			return YMODEM_TX_PENDING;
+		case YM_TIMEOUT:
+			ymodem_Abort(ymodem);
+			ymodem->nextStatus = YMODEM_TIMEOUT;
+			return YMODEM_TX_PENDING;
 		case YM_START_RX:
+			if (ymodem->streaming) {
+				/* YMODEM-G, block 0 is answered with a 'G' only */
+				ymodem->payloadTx[0] = CRCG;
+				ymodem->payloadLen = 1;
+				return YMODEM_TX_PENDING;
+			}
 			ymodem->payloadTx[0] = ACK;
-			ymodem->payloadTx[1] = CRC16;
-			ymodem->payloadLen = 2;
+			ymodem->payloadLen = 1;
+			ymodem_ExtAnswer(ymodem);
 			return YMODEM_TX_PENDING;
 			break;
 		case YM_RX_ERROR:
+			if (ymodem->streaming && (ymodem->packetsReceived > 0)) {
+				/* YMODEM-G has no retransmission, an error inside a file aborts */
+				ymodem_Abort(ymodem);
+				return YMODEM_TX_PENDING;
+			}
+			if (ymodem->retryPkt != ymodem->packetsReceived) {
+				ymodem->retryPkt = ymodem->packetsReceived;
+				ymodem->retries = 0;
+			}
+			if (++ymodem->retries > ymodem_RetryLimit(ymodem)) {
+				/* The same packet keeps failing, give up */
+				ymodem_Abort(ymodem);
+				ymodem->nextStatus = YMODEM_TIMEOUT;
+				return YMODEM_TX_PENDING;
+			}
 			ymodem->payloadTx[0] = NAK;
 			ymodem->payloadLen = 1;
+#if (YM_WINDOW > 0)
+			if ((ymodem->window > 0) && (ymodem->packetsReceived > 0)) {
+				/* Cumulative ACK of the last packet delivered, then the selective NAK of a
+				 * damaged packet or the first one missing */
+				ymodem->payloadTx[0] = ACK;
+				ymodem->payloadTx[1] = (uint8_t)(ymodem->packetsReceived - 1);
+				ymodem->payloadTx[2] = ymodem->payloadTx[1] ^ 0xFF;
+				ymodem->payloadTx[3] = NAK;
+				ymodem->payloadTx[4] = (ymodem->nakSeq >= 0) ? (uint8_t)ymodem->nakSeq : (uint8_t)ymodem->packetsReceived;
+				ymodem->payloadTx[5] = ymodem->payloadTx[4] ^ 0xFF;
+				ymodem->payloadLen = 6;
+				ymodem->nakSeq = -1;
+			}
+#endif
 			return YMODEM_TX_PENDING;
 			break;
 		case YM_RX_OK:
+			if (ymodem->streaming) {
+				/* YMODEM-G, data packets are not ACKed */
+				ymodem->payloadLen = 0;
+				return YMODEM_OK;
+			}
 			ymodem->payloadTx[0] = ACK;
 			ymodem->payloadLen = 1;
+#if (YM_WINDOW > 0)
+			if (ymodem->window > 0) {
+				/* Cumulative ACK, everything up to this packet was delivered */
+				ymodem->payloadTx[1] = (uint8_t)(ymodem->packetsReceived - 1);
+				ymodem->payloadTx[2] = ymodem->payloadTx[1] ^ 0xFF;
+				ymodem->payloadLen = 3;
+			}
+#endif
 			return YMODEM_TX_PENDING;
 			break;
 		case YM_RX_COMPLETE:
 			ymodem->payloadTx[0] = ACK;
-			ymodem->payloadTx[1] = CRC16;
-			ymodem->payloadLen = 2;
+			ymodem->payloadLen = 1;
+#if (YM_WINDOW > 0)
+			if (ymodem->window > 0) {
+				/* The EOT takes the sequence after the last packet, stale ACKs can't be taken for it */
+				ymodem->payloadTx[1] = ymodem->eotSeq;
+				ymodem->payloadTx[2] = ymodem->payloadTx[1] ^ 0xFF;
+				ymodem->payloadLen = 3;
+			}
+#endif
+			ymodem->payloadTx[ymodem->payloadLen++] = (ymodem->streaming) ? CRCG : CRC16;
 			return YMODEM_TX_PENDING;
 			break;
 		case YM_SUCCESS:
@@ -153,6 +379,10 @@ static ymodem_err_e GenerateResponse(ymodem_t *ymodem, ym_ret_t retVal) {
 			ymodem->nextStatus = YMODEM_COMPLETE;
 			return YMODEM_TX_PENDING;
 			break;
+		case YM_HELD:
+			ymodem->payloadLen = 0;
+			return YMODEM_PENDING;
+			break;
 		default: 
 			break;
 	}
@@ -189,12 +419,49 @@ ymodem_err_e 	ymodem_Reset(ymodem_t *ymodem){
 	assert (ymodem->initialized = YM_INSTANCE_INIT_MASK);
 
 	ymodem->fileSize 		= 0;
+	ymodem->fileSizeKnown	= 0;
+	ymodem->fileMtime		= 0;
+	ymodem->fileMode		= 0;
+	ymodem->fileSerial		= 0;
+	ymodem->fileOffset		= 0;
 	ymodem->prevC 			= 0;
 	ymodem->startOfPacket 	= 1;
 	ymodem->packetBytes 	= 0;
 	ymodem->packetSize 		= 0;
 	ymodem->packetsReceived	= 0;
 	ymodem->eotReceived 	= 0;
+	ymodem->filesReceived	= 0;
+#if (YM_CRC_INCREMENTAL > 0)
+	ymodem->crc 			= 0;
+#endif
+	ymodem->txHeld			= 0;
+	ymodem->cbPending		= 0;
+	ymodem->resync			= YM_SYNC_NONE;
+	ymodem->discardLeft		= 0;
+	ymodem->extCaps			= 0;
+	ymodem->retries			= 0;
+	ymodem->retryPkt		= 0;
+	ymodem->duplicates		= 0;
+	ymodem->idleMs			= 0;
+	ymodem->sessionMs		= 0;
+#if (YM_WINDOW > 0)
+	ymodem_ResetWindow(ymodem);
+#endif
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	ymodem->largeSize		= 0;
+#endif
+#if (YM_RESUME > 0)
+	ymodem->resumeOk		= 0;
+	ymodem->resumeAt		= 0;
+#endif
+#if (YM_LZ > 0)
+	ymodem->lzBits			= 0;
+	ymodem->lzPos			= 0;
+#endif
+#if (YM_DOUBLE_BUFFER > 0)
+	/* Whatever the application was draining is dropped */
+	ymodem_ReclaimBuffers(ymodem);
+#endif
 	ymodem->nextStatus 		= YMODEM_OK;
 
 	return YMODEM_OK;
@@ -218,30 +485,49 @@ ymodem_err_e ymodem_ReceiveByte(ymodem_t *ymodem, uint8_t c) {
 
 	/* Return status if just closed connection */
 	if (ymodem->nextStatus != YMODEM_OK) return ymodem->nextStatus;
+	ymodem->idleMs = 0;
 
 	do {	
+		if (ymodem->txHeld) {
+			/* Waiting for the application before answering, the sender must stay quiet.
+			 * Only a double CA is honoured */
+			if ((c == CA) && (ymodem->prevC == CA)) {
+				ret = YM_ABORTED;
+			} else if (ymodem->streaming && (ymodem->heldRet == YM_RX_OK)) {
+				/* A YMODEM-G sender does not wait, this data would be lost */
+				ret = YM_ABORT;
+			} else {
+				ret = YM_HELD;
+			}
+			break;
+		}
+		if (ymodem->resync != YM_SYNC_NONE) {
+			/* Discarding a broken packet or line noise */
+			ret = ymodem_Resync(ymodem, c);
+			break;
+		}
 		/* Receive full packet */
 		if (ymodem->startOfPacket) {
 			/* Process start of packet */
 			switch (c) {
 				case SOH:
-					ymodem->packetSize = YM_PACKET_SIZE;
-					/* start receiving payload */
-					ymodem->startOfPacket = 0;
-					ymodem->packetBytes++; //increment by 1 byte
-					ret = YM_OK;
-					break; 
+					ret = ymodem_StartPacket(ymodem, YM_PACKET_SIZE);
+					break;
 				case STX:
-					ymodem->packetSize = YM_PACKET_1K_SIZE;
-					/* start receiving payload */
-					ymodem->startOfPacket = 0;
-					ymodem->packetBytes++; //increment by 1 byte
-					ret = YM_OK;
+					ret = ymodem_StartPacket(ymodem, YM_PACKET_1K_SIZE);
+					break;
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+				case STX_LARGE:
+					if (ymodem->largeSize > 0) {
+						ret = ymodem_StartPacket(ymodem, ymodem->largeSize);
+						break;
+					}
+					/* Large blocks were not agreed, this is noise */
+					ret = ymodem_StartPurge(ymodem, c);
 					break;
+#endif
 				case EOT: 
-				/* One more packet comes after with 0,FF so reset this */
-					ymodem->eotReceived = 1;
-					ret = YM_RX_COMPLETE;
+					ret = ymodem_ProcessEot(ymodem);
 					break;
 				case CA:
 					/* Two of these aborts transfer */
@@ -253,38 +539,388 @@ ymodem_err_e ymodem_ReceiveByte(ymodem_t *ymodem, uint8_t c) {
 					break;
 				case ABORT1:
 				case ABORT2: 
+#if (YM_WINDOW > 0)
+					if ((ymodem->window > 0) && (ymodem->packetsReceived > 0)) {
+						/* Packets come back to back in a window, this is a stray payload
+						 * byte after a broken header rather than a user abort */
+						ret = ymodem_StartPurge(ymodem, c);
+						break;
+					}
+#endif
 					ret = YM_ABORT;
 					break;
 				default: 
-					ret = YM_RX_ERROR;
+					/* Noise, purge the line and send one NAK once it goes quiet
+					 * instead of one NAK per byte */
+					ret = ymodem_StartPurge(ymodem, c);
 					break;
 			}
 		} else {
 			/* receive rest of packet */
 			if (ymodem->packetBytes < (ymodem->packetSize + YM_PACKET_OVERHEAD)-1) {
+#if (YM_CRC_INCREMENTAL > 0)
+				/* Accumulate the payload CRC, the trailer is compared on the last byte */
+				if ((ymodem->packetBytes >= YM_PACKET_HEADER) && (ymodem->packetBytes < ymodem->packetSize + YM_PACKET_HEADER)) {
+					ymodem->crc = ymodem_CrcUpdate(ymodem, ymodem->crc, &c, 1);
+				}
+#endif
 				ymodem->packetData[ymodem->packetBytes++] = c;
 				ret = YM_OK;
-				break;
-			} else {
-				/* Last byte of packet */
-				ymodem->packetData[ymodem->packetBytes++] = c;
-				if (ymodem->packetData[YM_PACKET_SEQNO_INDEX] != ((ymodem->packetData[YM_PACKET_SEQNO_COMP_INDEX] ^ 0xFF) & 0xFF)) {
-					/* Check byte 1 == (byte 2 XOR 0xFF) */
+				if ((ymodem->packetBytes == YM_PACKET_HEADER) &&
+						((ymodem->packetData[YM_PACKET_SEQNO_INDEX] ^ ymodem->packetData[YM_PACKET_SEQNO_COMP_INDEX]) != 0xFF)) {
+					/* Check byte 1 == (byte 2 XOR 0xFF) as soon as it arrives, and skip the
+					 * rest of the packet instead of buffering it */
+					ymodem->resync = YM_SYNC_HEADER;
+					ymodem->discardLeft = ymodem->packetSize + YM_PACKET_OVERHEAD - YM_PACKET_HEADER;
+					ymodem->syncWin[1] = ymodem->packetData[YM_PACKET_SEQNO_INDEX];
+					ymodem->syncWin[2] = c;
 					ymodem->startOfPacket = 1;
 					ymodem->packetBytes = 0;
-					ret = YM_RX_ERROR;
-					break;
-				} else {
-					/* Full packet received */
-					ret = ymodem_ProcessPacket(ymodem);
-					ymodem->startOfPacket = 1;
-					ymodem->packetBytes = 0;
-					break;
 				}
+				break;
+			} else {
+				/* Last byte of packet, the header was checked on arrival */
+				ymodem->packetData[ymodem->packetBytes++] = c;
+				/* Full packet received */
+				ret = ymodem_ProcessPacket(ymodem);
+				ymodem->startOfPacket = 1;
+				ymodem->packetBytes = 0;
+				break;
 			}
 		}
 	} while (0); // Empty do while to avoid multiple "return" statements
 	ymodem->prevC = c;
+	if (ret == YM_HELD) {
+		/* Callback returned YMODEM_PENDING, see ymodem_CompleteCallback */
+		ymodem->txHeld = 1;
+	}
+#if (YM_ZERO_COPY > 0)
+	else if ((ret == YM_RX_OK) && (ymodem->packetData == NULL) && (ymodem->streaming == 0)) {
+		/* Every buffer is with the application, hold the ACK so the sender waits.
+		 * A YMODEM-G sender does not wait for it, a buffer must be back before the next packet */
+		ymodem->txHeld = 1;
+		ymodem->heldRet = ret;
+		ret = YM_HELD;
+	}
+#endif
+	if (ret == YM_OK) {
+		/* Nothing to answer, the common case inside a packet */
+		ymodem->payloadLen = 0;
+		return YMODEM_OK;
+	}
+	GenRet = ymodem_Respond(ymodem, ret);
+
+	return GenRet;
+}
+
+/**
+ * @brief  				Starts receiving a packet after its SOH/STX.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  size			Payload size announced by the start byte
+ * @return YM_RET_T 	YM_OK, or YM_RX_ERROR if there is no buffer to receive into
+ */
+static ym_ret_t ymodem_StartPacket(ymodem_t *ymodem, uint16_t size) {
+#if (YM_ZERO_COPY > 0)
+	if ((ymodem->packetData == NULL) && ((ymodem->packetData = ymodem_PopBuffer(ymodem)) == NULL)) {
+		/* No buffer submitted to receive into */
+		return YM_RX_ERROR;
+	}
+#endif
+	ymodem->packetSize = size;
+	/* A packet after a NAKed EOT means that EOT was a corrupted packet start */
+	ymodem->eotReceived = 0;
+	/* start receiving payload */
+	ymodem->startOfPacket = 0;
+#if (YM_CRC_INCREMENTAL > 0)
+	ymodem->crc = 0;
+#endif
+	ymodem->packetBytes = 1; // start byte is not stored
+	return YM_OK;
+}
+
+/**
+ * @brief  				Starts discarding line noise, see ymodem_Resync.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  c			Byte that could not start a packet
+ * @return YM_RET_T 	YM_OK
+ */
+static ym_ret_t ymodem_StartPurge(ymodem_t *ymodem, uint8_t c) {
+	ymodem->resync = YM_SYNC_PURGE;
+	ymodem->discardLeft = YM_PURGE_LIMIT;
+	ymodem->syncWin[1] = 0;
+	ymodem->syncWin[2] = c;
+	return YM_OK;
+}
+
+/**
+ * @brief  				Handles a byte while resynchronizing after a broken header or line noise.
+ * 						Bytes are dropped until a plausible SOH/STX/STX_LARGE, seq, ~seq triple shows up,
+ * 						which is taken as the start of the next packet. If none shows up within
+ * 						the length of the broken packet (YM_PURGE_LIMIT bytes for noise), or the
+ * 						line goes quiet (ymodem_LineIdle), a single NAK is sent. While purging
+ * 						noise, a double CA is still honoured.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  c			Received byte
+ * @return YM_RET_T 	YM_OK while discarding, YM_RX_ERROR to send the NAK
+ */
+static ym_ret_t ymodem_Resync(ymodem_t *ymodem, uint8_t c) {
+	uint8_t expected;
+	uint8_t seq;
+	uint16_t size;
+
+	ymodem->syncWin[0] = ymodem->syncWin[1];
+	ymodem->syncWin[1] = ymodem->syncWin[2];
+	ymodem->syncWin[2] = c;
+
+	if ((ymodem->resync == YM_SYNC_PURGE) && (c == CA) && (ymodem->prevC == CA)
+#if (YM_WINDOW > 0)
+			/* In a window the purge runs through packets sent back to back, a double CA
+			 * is only honoured at a packet start */
+			&& ((ymodem->window == 0) || (ymodem->packetsReceived == 0))
+#endif
+			) {
+		/* The purge may have started inside a packet, so an EOT is not trusted here:
+		 * the NAK after the purge makes the sender repeat it */
+		ymodem->resync = YM_SYNC_NONE;
+		return YM_ABORTED;
+	}
+
+	seq = ymodem->syncWin[1];
+	expected = (uint8_t)ymodem->packetsReceived;
+	size = ymodem_HeaderSize(ymodem, ymodem->syncWin[0]);
+	if ((size > 0) &&
+			((seq ^ ymodem->syncWin[2]) == 0xFF) &&
+			((seq == expected) || (seq == (uint8_t)(expected - 1))
+#if (YM_WINDOW > 0)
+			|| ((uint8_t)(seq - expected) < ymodem->window)
+#endif
+			)) {
+		/* Looks like a packet header, receive it */
+		if (ymodem_StartPacket(ymodem, size) == YM_OK) {
+			ymodem->packetData[YM_PACKET_SEQNO_INDEX] = seq;
+			ymodem->packetData[YM_PACKET_SEQNO_COMP_INDEX] = c;
+			ymodem->packetBytes = YM_PACKET_HEADER;
+			ymodem->resync = YM_SYNC_NONE;
+			return YM_OK;
+		}
+	}
+	if (ymodem->discardLeft > 0) {
+		ymodem->discardLeft--;
+	}
+	if (ymodem->discardLeft == 0) {
+		ymodem->resync = YM_SYNC_NONE;
+		return YM_RX_ERROR;
+	}
+	return YM_OK;
+}
+
+/**
+ * @brief  				Payload size of the packets started by c.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  c			Start byte
+ * @return uint16_t 	Payload size, 0 if c does not start a packet
+ */
+static uint16_t ymodem_HeaderSize(ymodem_t *ymodem, uint8_t c) {
+	(void)ymodem;
+	switch (c) {
+		case SOH:
+			return YM_PACKET_SIZE;
+		case STX:
+			return YM_PACKET_1K_SIZE;
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+		case STX_LARGE:
+			return ymodem->largeSize;
+#endif
+		default:
+			return 0;
+	}
+}
+
+/**
+ * @brief  				Selects YMODEM-G. The application starts the session with 'G' instead of
+ * 						'C', block 0 and EOT are answered with 'G', data packets are not ACKed and
+ * 						any error inside a file aborts the transfer. Only for error free links.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  enable		1 for YMODEM-G, 0 for the ACKed protocol
+ */
+void ymodem_SetStreaming(ymodem_t *ymodem, uint8_t enable) {
+	assert (ymodem != NULL);
+
+	ymodem->streaming = (enable != 0);
+}
+
+#if (YM_RESUME > 0)
+/**
+ * @brief  				Resumes the file announced by YMODEM_FILE_CB_NAME from the bytes the application
+ * 						has already committed, e.g. a checkpoint kept in flash by an interrupted transfer.
+ * 						Call it from the YMODEM_FILE_CB_NAME callback, or before completing it with
+ * 						ymodem_CompleteCallback. The offset is rounded down to a multiple of 1K and sent
+ * 						to the sender with the ACK of block 0. Sequence numbers go on as if the skipped
+ * 						part had been sent in 1K packets.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  committed	Bytes of this file already written by the application
+ * @return uint32_t		Offset of the first byte the data callback will get, 0 if the sender did not
+ * 						offer resume and the whole file is sent
+ */
+uint32_t ymodem_Resume(ymodem_t *ymodem, uint32_t committed) {
+	uint32_t offset;
+	uint32_t kb;
+	uint8_t span = 1;
+
+	assert (ymodem != NULL);
+
+	if ((ymodem->resumeOk == 0) || (ymodem->resumeAt != 0) || (ymodem->packetsReceived > 1)) {
+		return ymodem->resumeAt;
+	}
+	kb = ((committed < ymodem->fileSize) ? committed : ymodem->fileSize) / YM_PACKET_1K_SIZE;
+#if (YM_WINDOW > 0)
+	if (ymodem->window > 0) {
+		span = ymodem->window;
+	}
+#endif
+	/* A late copy of block 0 must not pass for a packet of the file, keep its sequence
+	 * number (0) out of the first packets expected */
+	while ((kb > 0) && ((uint8_t)(0 - (kb + 1)) < span)) {
+		kb--;
+	}
+	offset = kb * YM_PACKET_1K_SIZE;
+	if (offset > 0) {
+		ymodem->resumeAt = offset;
+		ymodem->fileOffset = offset;
+		ymodem->extCaps |= YM_CAP_RESUME;
+		ymodem->packetsReceived += offset / YM_PACKET_1K_SIZE;
+	}
+	return offset;
+}
+#endif
+
+/**
+ * @brief  				Tells the library the line has gone quiet, e.g. from a UART idle-line
+ * 						interrupt or a receive timeout. If input is being discarded after an
+ * 						error, the single NAK is sent now instead of after a full packet time.
+ * 						A packet cut short is dropped and NAKed. In a window the first missing
+ * 						packet is asked for again.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @return YMODEM_T 	YMODEM_TX_PENDING if a NAK was sent, otherwise YMODEM_OK.
+ */
+ymodem_err_e ymodem_LineIdle(ymodem_t *ymodem) {
+	assert (ymodem != NULL);
+
+	if ((ymodem->nextStatus == YMODEM_OK) && (ymodem->resync == YM_SYNC_NONE) && (ymodem->startOfPacket == 0)) {
+		/* A packet cut short, drop what was received of it */
+		ymodem->startOfPacket = 1;
+		ymodem->packetBytes = 0;
+		return ymodem_Respond(ymodem, YM_RX_ERROR);
+	}
+#if (YM_WINDOW > 0)
+	if ((ymodem->nextStatus == YMODEM_OK) && (ymodem->resync == YM_SYNC_NONE) && (ymodem->txHeld == 0) &&
+			(ymodem->window > 0) && (ymodem->packetsReceived > 0)) {
+		if (ymodem->packetsReceived == ymodem_FirstPacket(ymodem)) {
+			/* Nothing of the file yet, the answer to block 0 may have been lost: repeat it
+			 * without the ACK, a sender waiting for packet 1 takes the 'C' as a NAK */
+			ymodem->payloadLen = 0;
+			ymodem_ExtAnswer(ymodem);
+			ymodem_WriteSerial(ymodem);
+			return YMODEM_TX_PENDING;
+		}
+		/* The sender is waiting, ask again for the first missing packet */
+		return ymodem_Respond(ymodem, YM_RX_ERROR);
+	}
+#endif
+	if ((ymodem->nextStatus != YMODEM_OK) || (ymodem->resync == YM_SYNC_NONE)) {
+		return YMODEM_OK;
+	}
+	ymodem->resync = YM_SYNC_NONE;
+	return ymodem_Respond(ymodem, YM_RX_ERROR);
+}
+
+/**
+ * @brief  				Advances the receiver timers, to be called periodically (e.g. from a 10 ms
+ * 						tick) with the time elapsed since the previous call. The receiver then
+ * 						times out by itself:
+ * 						- while waiting for block 0, 'C' ('G' for YMODEM-G) is sent every
+ * 						  YM_START_POLL_MS, so the application does not need to start the session;
+ * 						- a packet stalled for YM_BYTE_TIMEOUT_MS, or noise being discarded, is
+ * 						  handled as by ymodem_LineIdle;
+ * 						- when no packet starts within YM_PACKET_TIMEOUT_MS of the last answer, the
+ * 						  answer is taken as lost and a NAK is sent (in a window, as ymodem_LineIdle);
+ * 						- the transfer is cancelled once YM_SESSION_TIMEOUT_MS has elapsed.
+ * 						While a response is held for the application, no timeout runs but the session one.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  elapsedMs	Milliseconds since the previous call
+ * @return YMODEM_T 	YMODEM_TX_PENDING if something was sent, YMODEM_PENDING while a response is
+ * 						held, YMODEM_TIMEOUT (or the status of the closed transfer) once cancelled,
+ * 						otherwise YMODEM_OK.
+ */
+ymodem_err_e ymodem_Tick(ymodem_t *ymodem, uint32_t elapsedMs) {
+	ymodem_err_e ret = YMODEM_OK;
+
+	assert (ymodem != NULL);
+
+	if (ymodem->nextStatus != YMODEM_OK) return ymodem->nextStatus;
+
+	ymodem->sessionMs += elapsedMs;
+#if (YM_SESSION_TIMEOUT_MS > 0)
+	if (ymodem->sessionMs >= YM_SESSION_TIMEOUT_MS) {
+		ymodem->txHeld = 0;
+		ymodem->cbPending = 0;
+		ymodem_Respond(ymodem, YM_TIMEOUT);
+		return ymodem->nextStatus;
+	}
+#endif
+	if (ymodem->txHeld) {
+		/* The sender is waiting for the held answer, not the other way round */
+		ymodem->idleMs = 0;
+		return YMODEM_PENDING;
+	}
+	ymodem->idleMs += elapsedMs;
+
+	if ((ymodem->startOfPacket == 0) || (ymodem->resync != YM_SYNC_NONE)) {
+		/* The rest of the packet or of the noise is not coming */
+		if (ymodem->idleMs >= YM_BYTE_TIMEOUT_MS) {
+			ret = ymodem_LineIdle(ymodem);
+		}
+	} else if (ymodem->packetsReceived == 0) {
+		if (ymodem->idleMs >= YM_START_POLL_MS) {
+			/* Waiting for block 0, poll the sender */
+			ymodem->payloadTx[0] = (ymodem->streaming) ? CRCG : CRC16;
+			ymodem->payloadLen = 1;
+			ymodem_WriteSerial(ymodem);
+			ret = YMODEM_TX_PENDING;
+		}
+	} else if (ymodem->idleMs >= YM_PACKET_TIMEOUT_MS) {
+		/* The last answer was lost, or the sender is stuck: ask again */
+		ret = ymodem_LineIdle(ymodem);
+		if (ret == YMODEM_OK) {
+			ret = ymodem_Respond(ymodem, YM_RX_ERROR);
+		}
+	}
+	if (ymodem->nextStatus != YMODEM_OK) {
+		/* Gave up, the CA were sent */
+		return ymodem->nextStatus;
+	}
+	return ret;
+}
+
+/**
+ * @brief  				Translates an internal result into the response to the sender, sends it
+ * 						and informs the application of an abort.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  ret			Internal result of the processed input
+ * @return YMODEM_T 	Status to return to the application
+ */
+static ymodem_err_e ymodem_Respond(ymodem_t *ymodem, ym_ret_t ret) {
+	ymodem_err_e GenRet;
+
 	GenRet = GenerateResponse(ymodem, ret);
 	switch (GenRet){
 	case YMODEM_TX_PENDING:
@@ -301,15 +937,239 @@ ymodem_err_e ymodem_ReceiveByte(ymodem_t *ymodem, uint8_t c) {
 	return GenRet;
 }
 
+/**
+ * @brief  				Sends a held response once nothing holds it any more.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @return YMODEM_T 	YMODEM_PENDING while still held, otherwise the status of the response.
+ */
+static ymodem_err_e ymodem_ReleaseHeld(ymodem_t *ymodem) {
+	if (ymodem->txHeld == 0) {
+		return YMODEM_OK;
+	}
+	if (ymodem->nextStatus != YMODEM_OK) {
+		/* Aborted while waiting, nothing left to answer */
+		ymodem->txHeld = 0;
+		ymodem->cbPending = 0;
+		return ymodem->nextStatus;
+	}
+	if (ymodem->cbPending) {
+		return YMODEM_PENDING;
+	}
+#if (YM_ZERO_COPY > 0)
+	if ((ymodem->heldRet == YM_RX_OK) && (ymodem->packetData == NULL) && (ymodem->streaming == 0)) {
+		return YMODEM_PENDING;
+	}
+#endif
+	ymodem->txHeld = 0;
+	return ymodem_Respond(ymodem, (ym_ret_t)ymodem->heldRet);
+}
+
+/**
+ * @brief  				Completes a YMODEM_FILE_CB_NAME or YMODEM_FILE_CB_DATA callback that returned
+ * 						YMODEM_PENDING, and sends the response held for it (ACK, or CA on error).
+ * 						May be called from another context than ymodem_ReceiveByte, but not
+ * 						concurrently with it.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  status		YMODEM_OK if the operation succeeded, an error otherwise
+ * @return YMODEM_T 	Status of the response, like ymodem_ReceiveByte.
+ */
+ymodem_err_e ymodem_CompleteCallback(ymodem_t *ymodem, ymodem_err_e status) {
+	assert (ymodem != NULL);
+
+	if (ymodem->cbPending == 0) {
+		return ymodem_ReleaseHeld(ymodem);
+	}
+	ymodem->cbPending = 0;
+	if (status != YMODEM_OK) {
+		ymodem->heldRet = (ymodem->heldRet == YM_START_RX) ? YM_SIZE_ERR : YM_WRITE_ERR;
+	}
+	return ymodem_ReleaseHeld(ymodem);
+}
+
+#if (YM_ZERO_COPY > 0)
+/**
+ * @brief  				Hands a packet buffer to the library. Buffers are used in submission order,
+ * 						one per packet. The buffer given with YMODEM_FILE_CB_DATA belongs to the
+ * 						application from then on, and can be submitted again once it is consumed
+ * 						(see YM_PACKET_BUFFER). If an ACK was held waiting for a buffer, it is sent.
+ * 						With YM_DOUBLE_BUFFER, an internal buffer that is not with the application
+ * 						(taken back by ymodem_Reset, or already released) is ignored.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  buf			Buffer of at least YM_PACKET_MAX_OVRHD_SIZE bytes
+ * @return YMODEM_T 	YMODEM_TX_PENDING if a held response was sent, YMODEM_PENDING if it is still
+ * 						held, otherwise YMODEM_OK.
+ */
+ymodem_err_e ymodem_SubmitBuffer(ymodem_t *ymodem, uint8_t *buf) {
+	assert (ymodem != NULL);
+	assert (buf != NULL);
+#if (YM_DOUBLE_BUFFER > 0)
+	uint8_t bit = ymodem_BufferBit(ymodem, buf);
+
+	if (bit != 0) {
+		if ((ymodem->bufOut & bit) == 0) {
+			/* Taken back by ymodem_Reset, or released twice: it is already in use */
+			return YMODEM_OK;
+		}
+		ymodem->bufOut &= (uint8_t)~bit;
+	}
+#endif
+	assert (ymodem->bufCount < YM_BUFFER_POOL_DEPTH);
+
+	ymodem->bufPool[(ymodem->bufHead + ymodem->bufCount) % YM_BUFFER_POOL_DEPTH] = buf;
+	ymodem->bufCount++;
+
+	if (ymodem->packetData == NULL) {
+		ymodem->packetData = ymodem_PopBuffer(ymodem);
+	}
+	return ymodem_ReleaseHeld(ymodem);
+}
+
+/**
+ * @brief  				Gives back the buffer holding data delivered by YMODEM_FILE_CB_DATA, once the
+ * 						application is done with it. Same as ymodem_SubmitBuffer(YM_PACKET_BUFFER(data)).
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  data			Data pointer received with YMODEM_FILE_CB_DATA
+ * @return YMODEM_T 	As ymodem_SubmitBuffer.
+ */
+ymodem_err_e ymodem_ReleaseBuffer(ymodem_t *ymodem, uint8_t *data) {
+	assert (data != NULL);
+
+	return ymodem_SubmitBuffer(ymodem, YM_PACKET_BUFFER(data));
+}
+
+static uint8_t *ymodem_PopBuffer(ymodem_t *ymodem) {
+	uint8_t *buf = NULL;
+
+	if (ymodem->bufCount > 0) {
+		buf = ymodem->bufPool[ymodem->bufHead];
+		ymodem->bufHead = (ymodem->bufHead + 1) % YM_BUFFER_POOL_DEPTH;
+		ymodem->bufCount--;
+	}
+	return buf;
+}
+
+#if (YM_DOUBLE_BUFFER > 0)
+/**
+ * @brief  				Takes both internal buffers back: the first one receives the next packet,
+ * 						the other one waits in the pool. Nothing is sent, so it is safe on an
+ * 						instance that is not set up yet.
+ *
+ * @param  ymodem		Ymodem instance.
+ */
+static void ymodem_ReclaimBuffers(ymodem_t *ymodem) {
+	ymodem->packetData		= ymodem->packetBuf[0];
+	ymodem->bufPool[0]		= ymodem->packetBuf[1];
+	ymodem->bufHead			= 0;
+	ymodem->bufCount		= 1;
+	ymodem->bufOut			= 0;
+}
+
+/** bufOut bit of an internal buffer, 0 for a buffer of the application **/
+static uint8_t ymodem_BufferBit(ymodem_t *ymodem, uint8_t *buf) {
+	if (buf == ymodem->packetBuf[0]) {
+		return 0x01;
+	}
+	return (buf == ymodem->packetBuf[1]) ? 0x02 : 0x00;
+}
+#endif
+#endif
+
+/**
+ * @brief  				Receives a chunk of bytes from a YMODEM Sender, such as a UART DMA block or
+ * 						the result of a read(). Payload runs are copied straight into the packet
+ * 						buffer, all other bytes go through ymodem_ReceiveByte.
+ * 						Returns as soon as a byte produces anything other than YMODEM_OK, so the
+ * 						caller must call again with the remaining bytes.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  buf			Bytes from the YMODEM Sender
+ * @param  len			Number of bytes in buf
+ * @param  consumed		Number of bytes of buf processed, may be NULL
+ * @return YMODEM_T 	Status of the last byte processed, YMODEM_OK if all bytes were consumed.
+ */
+ymodem_err_e ymodem_ReceiveBuffer(ymodem_t *ymodem, const uint8_t *buf, size_t len, size_t *consumed) {
+	ymodem_err_e ret = YMODEM_OK;
+	size_t i = 0;
+	size_t run;
+
+	assert (ymodem != NULL);
+	assert (buf != NULL || len == 0);
+
+	if (len > 0) {
+		ymodem->idleMs = 0;
+	}
+	while (i < len) {
+		if ((ymodem->nextStatus == YMODEM_OK) && (ymodem->startOfPacket == 0) && (ymodem->txHeld == 0) &&
+				(ymodem->packetBytes >= YM_PACKET_HEADER) &&
+				(ymodem->packetBytes < (ymodem->packetSize + YM_PACKET_OVERHEAD) - 1)) {
+			/* Inside a packet with a valid header, copy everything up to (not including) its last byte */
+			run = (ymodem->packetSize + YM_PACKET_OVERHEAD) - 1 - ymodem->packetBytes;
+			if (run > len - i) {
+				run = len - i;
+			}
+#if (YM_CRC_INCREMENTAL > 0)
+			{
+				uint16_t start = ymodem->packetBytes;
+				uint16_t end = ymodem->packetBytes + run;
+
+				if (start < YM_PACKET_HEADER) {
+					start = YM_PACKET_HEADER;
+				}
+				if (end > ymodem->packetSize + YM_PACKET_HEADER) {
+					end = ymodem->packetSize + YM_PACKET_HEADER;
+				}
+				if (start < end) {
+					ymodem->crc = ymodem_CrcUpdate(ymodem, ymodem->crc, buf + i + (start - ymodem->packetBytes), end - start);
+				}
+			}
+#endif
+			memcpy(ymodem->packetData + ymodem->packetBytes, buf + i, run);
+			ymodem->packetBytes += run;
+			i += run;
+			ymodem->prevC = buf[i - 1];
+		} else {
+			ret = ymodem_ReceiveByte(ymodem, buf[i++]);
+			if (ret != YMODEM_OK) {
+				break;
+			}
+		}
+	}
+
+	if (consumed != NULL) {
+		*consumed = i;
+	}
+	return ret;
+}
+
 static ym_ret_t ymodem_ProcessPacket(ymodem_t *ymodem) {
 	ym_ret_t ret = YM_OK;
 	do {
-		if (ymodem->eotReceived == 1) {
-			ymodem_FileCallback(ymodem, YMODEM_FILE_CB_END, NULL, 0);
-			ret = YM_SUCCESS;
+#if (YM_WINDOW > 0)
+		if ((ymodem->window > 0) && (ymodem->packetsReceived > 0)) {
+			ret = ymodem_ProcessWindowPacket(ymodem);
 			break;
+		}
+#endif
 		/* Check byte 1 == num of bytes received */
-		} else if ((ymodem->packetData[YM_PACKET_SEQNO_INDEX] & 0xFF) != (ymodem->packetsReceived & 0xFF)) {
+		if ((ymodem->packetData[YM_PACKET_SEQNO_INDEX] & 0xFF) != (ymodem->packetsReceived & 0xFF)) {
+			if ((ymodem->packetData[YM_PACKET_SEQNO_INDEX] == 0) && (ymodem->packetsReceived == ymodem_FirstPacket(ymodem)) &&
+					(ymodem_CheckCRC(ymodem) == YM_OK)) {
+				/* Block 0 again before any data, its answer was lost. Answer it again,
+				 * the application already has the name */
+				ret = YM_START_RX;
+				break;
+			}
+			if ((ymodem->packetData[YM_PACKET_SEQNO_INDEX] == (uint8_t)(ymodem->packetsReceived - 1)) &&
+					(ymodem->packetsReceived > ymodem_FirstPacket(ymodem)) && (ymodem_CheckCRC(ymodem) == YM_OK)) {
+				/* The previous packet again, its ACK was lost. It was delivered already, ACK it again */
+				ymodem->duplicates++;
+				ret = YM_RX_OK;
+				break;
+			}
 			/* Send a NAK */
 			ret = YM_RX_ERROR;
 			break;
@@ -329,6 +1189,37 @@ static ym_ret_t ymodem_ProcessPacket(ymodem_t *ymodem) {
 	return ret;
 }
 
+/**
+ * @brief  				Handles an EOT. The first one is NAKed, so a corrupted packet start can not
+ * 						end the file, and the second one closes the file. The receiver then asks
+ * 						for the block 0 of the next file in the batch.
+ *
+ * @return YM_RET_T 	YM_RX_ERROR for the first EOT, YM_RX_COMPLETE for the second
+ */
+static ym_ret_t ymodem_ProcessEot(ymodem_t *ymodem) {
+	if (ymodem->packetsReceived == 0) {
+		/* No file open, the ACK of the last EOT was lost */
+		return (ymodem->filesReceived > 0) ? YM_RX_COMPLETE : YM_RX_ERROR;
+	}
+	if ((ymodem->eotReceived == 0) && (ymodem->streaming == 0)) {
+		ymodem->eotReceived = 1;
+		return YM_RX_ERROR;
+	}
+#if (YM_DIGEST > 0)
+	ymodem_DigestFinish(ymodem);
+#endif
+	ymodem_FileCallback(ymodem, YMODEM_FILE_CB_END, NULL, 0);
+	ymodem->eotReceived = 0;
+	ymodem->extCaps = 0;
+#if (YM_WINDOW > 0)
+	/* The window stays until the next block 0, a repeated EOT is answered the same way */
+	ymodem->eotSeq = (uint8_t)ymodem->packetsReceived;
+#endif
+	ymodem->packetsReceived = 0;
+	ymodem->filesReceived++;
+	return YM_RX_COMPLETE;
+}
+
 /**
  * @brief  				Writes a data packet to the flash set in ymodem_conf.h
  * 						Optionally validates the writes.
@@ -339,23 +1230,158 @@ static ym_ret_t ymodem_ProcessDataPacket(ymodem_t *ymodem) {
 	ym_ret_t ret;
 	ymodem_err_e err;
 	uint8_t *buffIn;
+	uint32_t len;
 
 	do { 
 		buffIn = (uint8_t *)ymodem->packetData + YM_PACKET_HEADER;
-		err = ymodem_FileCallback(ymodem, YMODEM_FILE_CB_DATA, buffIn, ymodem->packetSize);
+#if (YM_LZ > 0)
+		if (ymodem->lzBits > 0) {
+			ret = ymodem_LzDeliver(ymodem, buffIn, ymodem->packetSize);
+			ymodem->packetsReceived++;
+			break;
+		}
+#endif
+		len = ymodem_DataLength(ymodem, ymodem->packetSize);
+		if (len == 0) {
+			/* Nothing but padding past the end of the file, the buffer is kept */
+			ymodem->packetsReceived++;
+			ret = YM_RX_OK;
+			break;
+		}
+#if (YM_DIGEST > 0)
+		ymodem_DigestUpdate(ymodem, buffIn, len);
+#endif
+		err = ymodem_FileCallback(ymodem, YMODEM_FILE_CB_DATA, buffIn, len);
+		ymodem->fileOffset += len;
 		if (err == YMODEM_OK){
 			ret = YM_RX_OK;
 		}
+		else if (err == YMODEM_PENDING){
+			ymodem->heldRet = YM_RX_OK;
+			ymodem->cbPending = 1;
+			ret = YM_HELD;
+		}
 		else{
 			ret = YM_WRITE_ERR;
 		}
 		ymodem->packetsReceived++;
+#if (YM_ZERO_COPY > 0)
+		/* The buffer now belongs to the application, move on to the next one */
+#if (YM_DOUBLE_BUFFER > 0)
+		ymodem->bufOut |= ymodem_BufferBit(ymodem, ymodem->packetData);
+#endif
+		ymodem->packetData = ymodem_PopBuffer(ymodem);
+#endif
 
 	} while(0);
 	return ret;
 }
 
-
+/**
+ * @brief  				Bytes of a data packet that belong to the file: all of them, or what is left
+ * 						of the file when block 0 gave its size, so the padding is not delivered.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  size			Payload size of the packet
+ * @return uint32_t		Bytes to deliver, 0 for a packet past the end of the file
+ */
+static uint32_t ymodem_DataLength(ymodem_t *ymodem, uint16_t size) {
+	if (ymodem->fileSizeKnown == 0) {
+		return size;
+	}
+	if (ymodem->fileOffset >= ymodem->fileSize) {
+		return 0;
+	}
+	return ((ymodem->fileSize - ymodem->fileOffset) < size) ? (ymodem->fileSize - ymodem->fileOffset) : size;
+}
+
+#if (YM_LZ > 0)
+/**
+ * @brief  				Decompresses a data packet into the history window and delivers the file data
+ * 						to YMODEM_FILE_CB_DATA, one call each time the window wraps and one at the end.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  data			Packet payload
+ * @param  size			Payload size
+ * @return YM_RET_T 	YM_RX_OK, YM_WRITE_ERR if the callback failed, YM_ABORT for a malformed packet
+ */
+static ym_ret_t ymodem_LzDeliver(ymodem_t *ymodem, const uint8_t *data, uint16_t size) {
+	const uint16_t mask = (1 << YM_LZ_WINDOW_BITS) - 1;
+	const uint16_t distMask = (1 << ymodem->lzBits) - 1;
+	uint16_t count = data[0] | (data[1] << 8);
+	uint16_t start = ymodem->lzPos;
+	uint16_t pos = ymodem->lzPos;
+	uint16_t i = 2;
+	uint16_t end;
+	uint16_t word;
+	uint16_t len;
+	uint16_t dist;
+	uint8_t flags = 0;
+	uint8_t bit = 8;
+
+	end = 2 + (count & ~YM_LZ_STORED);
+	if (end > size) {
+		/* The CRC was good, the sender is broken */
+		return YM_ABORT;
+	}
+	while (i < end) {
+		len = 1;
+		dist = 0;
+		if (!(count & YM_LZ_STORED)) {
+			if (bit == 8) {
+				flags = data[i++];
+				bit = 0;
+				continue;
+			}
+			if (flags & (1 << bit++)) {
+				if (i + 2 > end) {
+					return YM_ABORT;
+				}
+				word = data[i] | (data[i + 1] << 8);
+				i += 2;
+				dist = (word & distMask) + 1;
+				len = (word >> ymodem->lzBits) + YM_LZ_MIN_MATCH;
+			}
+		}
+		while (len-- > 0) {
+			ymodem->lzRing[pos] = (dist > 0) ? ymodem->lzRing[(pos - dist) & mask] : data[i++];
+			pos = (pos + 1) & mask;
+			if (pos == 0) {
+				/* The window wraps, deliver its end before it is written over */
+				if (ymodem_LzFlush(ymodem, start, mask + 1) != YM_OK) {
+					return YM_WRITE_ERR;
+				}
+				start = 0;
+			}
+		}
+	}
+	ymodem->lzPos = pos;
+	if (ymodem_LzFlush(ymodem, start, pos) != YM_OK) {
+		return YM_WRITE_ERR;
+	}
+	return YM_RX_OK;
+}
+
+/**
+ * @brief  				Delivers lzRing[start..end) to YMODEM_FILE_CB_DATA, cut to the file size.
+ *
+ * @return YM_RET_T 	YM_OK, or YM_WRITE_ERR if the callback failed. YMODEM_PENDING can not be
+ * 						honoured, the window is written over by the next packet.
+ */
+static ym_ret_t ymodem_LzFlush(ymodem_t *ymodem, uint16_t start, uint16_t end) {
+	uint32_t len = ymodem_DataLength(ymodem, end - start);
+
+#if (YM_DIGEST > 0)
+	ymodem_DigestUpdate(ymodem, ymodem->lzRing + start, len);
+#endif
+	if ((len > 0) && (ymodem_FileCallback(ymodem, YMODEM_FILE_CB_DATA, ymodem->lzRing + start, len) != YMODEM_OK)) {
+		return YM_WRITE_ERR;
+	}
+	ymodem->fileOffset += len;
+	return YM_OK;
+}
+#endif
+
 /**
  * @brief  			Gets data from the first YMODEM packet.
  * 
@@ -366,6 +1392,7 @@ static ym_ret_t ymodem_ProcessFirstPacket(ymodem_t *ymodem) {
 	ymodem_err_e err;
 	int32_t i; 
 	uint8_t *filePtr; 
+	uint8_t *end;
 	do {
 		/* Filename packet */
 		if (ymodem->packetData[YM_PACKET_HEADER] != 0) {
@@ -373,23 +1400,43 @@ static ym_ret_t ymodem_ProcessFirstPacket(ymodem_t *ymodem) {
 			/* Get File Name */
 			filePtr = ymodem->packetData + YM_PACKET_HEADER;
 			i = 0;
-			while ((i < YM_FILE_NAME_LENGTH) && (*filePtr != '\0')){
+			while ((i < YM_FILE_NAME_LENGTH - 1) && (*filePtr != '\0')){
 				ymodem->fileName[i++] = *filePtr++;
 			}
 			ymodem->fileName[i++] = '\0';
 
 			i = 0;
 			filePtr++;
-			while ((i < YM_FILE_SIZE_LENGTH)  && (*filePtr != ' ')){
+			while ((i < YM_FILE_SIZE_LENGTH - 1) && (*filePtr != ' ') && (*filePtr != '\0')){
 				ymodem->fileSizeStr[i++] = *filePtr++;
 			}
 			ymodem->fileSizeStr[i++] = '\0';
-			Str2Int(ymodem->fileSizeStr, &ymodem->fileSize);
+			ymodem->fileSize = 0;
+			ymodem->fileSizeKnown = (ymodem->fileSizeStr[0] != '\0') && Str2Int(ymodem->fileSizeStr, &ymodem->fileSize);
+			/* Optional octal fields: modification time, mode, serial number */
+			end = ymodem->packetData + YM_PACKET_HEADER + ymodem->packetSize;
+			filePtr = Str2Oct(filePtr, end, &ymodem->fileMtime);
+			filePtr = Str2Oct(filePtr, end, &ymodem->fileMode);
+			filePtr = Str2Oct(filePtr, end, &ymodem->fileSerial);
+			ymodem->fileOffset = 0;
+#if (YM_DIGEST > 0)
+			ymodem_DigestStart(ymodem);
+#endif
+			/* Skip the rest of the metadata, extensions follow its NUL */
+			while ((filePtr < end) && (*filePtr != '\0')) {
+				filePtr++;
+			}
+			ymodem_ParseExtensions(ymodem, filePtr + 1, end);
 
 			err = ymodem_FileCallback(ymodem, YMODEM_FILE_CB_NAME, ymodem->fileName, ymodem->fileSize);
 			if (err == YMODEM_OK){
 				ret = YM_START_RX;
 			}
+			else if (err == YMODEM_PENDING){
+				ymodem->heldRet = YM_START_RX;
+				ymodem->cbPending = 1;
+				ret = YM_HELD;
+			}
 			else{
 				ret = YM_SIZE_ERR;
 			}
@@ -397,8 +1444,8 @@ static ym_ret_t ymodem_ProcessFirstPacket(ymodem_t *ymodem) {
 			break;
 
 		} else {
-			/* Filename packet is empty, end session */ 
-			ret = YM_ABORT;
+			/* Filename packet is empty, end of the batch. Nothing received at all is an abort */
+			ret = (ymodem->filesReceived > 0) ? YM_SUCCESS : YM_ABORT;
 			break;
 		}
 
@@ -406,12 +1453,1222 @@ static ym_ret_t ymodem_ProcessFirstPacket(ymodem_t *ymodem) {
 	return ret;
 }
 
+/**
+ * @brief  				Reads the block 0 extensions offered by the sender and keeps the ones this
+ * 						receiver supports, they are answered with the ACK of block 0.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  ext			First byte after the metadata
+ * @param  end			End of the block 0 payload
+ */
+static void ymodem_ParseExtensions(ymodem_t *ymodem, const uint8_t *ext, const uint8_t *end) {
+	uint8_t caps;
+#if (YM_DIGEST > 0)
+	uint8_t given;
+#endif
+
+	ymodem->extCaps = 0;
+#if (YM_WINDOW > 0)
+	ymodem_ResetWindow(ymodem);
+#endif
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	ymodem->largeSize = 0;
+#endif
+#if (YM_RESUME > 0)
+	ymodem->resumeOk = 0;
+	ymodem->resumeAt = 0;
+#endif
+#if (YM_LZ > 0)
+	ymodem->lzBits = 0;
+	ymodem->lzPos = 0;
+#endif
+#if (YM_DIGEST > 0)
+	ymodem->digestGiven = 0;
+#endif
+	if (ymodem->streaming || (ext + 2 > end) || (ext[0] != YM_EXT_MARKER)) {
+		/* No extension, or YMODEM-G which answers block 0 with 'G' only */
+		return;
+	}
+	caps = ext[1];
+	ext += 2;
+	if (caps & YM_CAP_WINDOW) {
+		if (ext >= end) {
+			return;
+		}
+#if (YM_WINDOW > 0)
+		if (*ext >= 2) {
+			ymodem->window = (*ext < YM_WINDOW) ? *ext : YM_WINDOW;
+			ymodem->extCaps |= YM_CAP_WINDOW;
+		}
+#endif
+		ext++;
+	}
+	if (caps & YM_CAP_LARGE) {
+		if (ext >= end) {
+			return;
+		}
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+		/* The reorder slots of the window hold 1K packets, the window wins */
+		if ((*ext >= 2) && !(ymodem->extCaps & YM_CAP_WINDOW)) {
+			ymodem->largeSize = ((*ext < (YM_PACKET_MAX_SIZE / 1024)) ? *ext : (YM_PACKET_MAX_SIZE / 1024)) * 1024;
+			ymodem->extCaps |= YM_CAP_LARGE;
+		}
+#endif
+		ext++;
+	}
+#if (YM_RESUME > 0)
+	if (caps & YM_CAP_RESUME) {
+		/* Answered only if the application resumes, see ymodem_Resume */
+		ymodem->resumeOk = 1;
+	}
+#endif
+	if (caps & YM_CAP_LZ) {
+		if (ext >= end) {
+			return;
+		}
+#if (YM_LZ > 0)
+		/* A window delivers packets out of order, the history would not follow */
+		if ((*ext >= 8) && !(ymodem->extCaps & YM_CAP_WINDOW)) {
+			ymodem->lzBits = (*ext < YM_LZ_WINDOW_BITS) ? *ext : YM_LZ_WINDOW_BITS;
+			memset(ymodem->lzRing, 0, sizeof(ymodem->lzRing));
+			ymodem->extCaps |= YM_CAP_LZ;
+		}
+#endif
+		ext++;
+	}
+#if (YM_DIGEST > 0)
+	/* Not answered, and last in bit order: without YM_DIGEST it needs no parsing */
+	if ((caps & YM_CAP_DIGEST) && (ext < end)) {
+		given = *ext++ & (YM_DIGEST_CRC32 | YM_DIGEST_SHA256);
+		if (ext + ((given & YM_DIGEST_CRC32) ? 4 : 0) + ((given & YM_DIGEST_SHA256) ? 32 : 0) > end) {
+			return;
+		}
+		if (given & YM_DIGEST_CRC32) {
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+			ymodem->crc32Given = (uint32_t)ext[0] | ((uint32_t)ext[1] << 8) | ((uint32_t)ext[2] << 16) | ((uint32_t)ext[3] << 24);
+#endif
+			ext += 4;
+		}
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+		if (given & YM_DIGEST_SHA256) {
+			memcpy(ymodem->sha256Given, ext, 32);
+		}
+#endif
+		ymodem->digestGiven = given;
+	}
+#endif
+}
+
+/**
+ * @brief  				Appends the answer to the block 0 extensions, the ones accepted, and the 'C'
+ * 						asking for the data to payloadTx.
+ *
+ * @param  ymodem		Ymodem instance.
+ */
+static void ymodem_ExtAnswer(ymodem_t *ymodem) {
+	if (ymodem->extCaps != 0) {
+		ymodem->payloadTx[ymodem->payloadLen++] = YM_EXT_MARKER;
+		ymodem->payloadTx[ymodem->payloadLen++] = ymodem->extCaps;
+#if (YM_WINDOW > 0)
+		if (ymodem->extCaps & YM_CAP_WINDOW) {
+			ymodem->payloadTx[ymodem->payloadLen++] = ymodem->window;
+		}
+#endif
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+		if (ymodem->extCaps & YM_CAP_LARGE) {
+			ymodem->payloadTx[ymodem->payloadLen++] = (uint8_t)(ymodem->largeSize / 1024);
+		}
+#endif
+#if (YM_RESUME > 0)
+		if (ymodem->extCaps & YM_CAP_RESUME) {
+			uint32_t kb = ymodem->resumeAt / YM_PACKET_1K_SIZE;
+			int i;
+
+			for (i = YM_RESUME_DIGITS - 1; i >= 0; i--) {
+				ymodem->payloadTx[ymodem->payloadLen + i] = '0' + (kb % 10);
+				kb /= 10;
+			}
+			ymodem->payloadLen += YM_RESUME_DIGITS;
+			ymodem->payloadTx[ymodem->payloadLen++] = ymodem_ResumeCheck(ymodem->resumeAt / YM_PACKET_1K_SIZE);
+		}
+#endif
+#if (YM_LZ > 0)
+		if (ymodem->extCaps & YM_CAP_LZ) {
+			ymodem->payloadTx[ymodem->payloadLen++] = ymodem->lzBits;
+		}
+#endif
+	}
+	ymodem->payloadTx[ymodem->payloadLen++] = CRC16;
+}
+
+/**
+ * @brief  First data packet of the current file, after the part skipped by a resume
+ *
+ */
+static int32_t ymodem_FirstPacket(ymodem_t *ymodem) {
+#if (YM_RESUME > 0)
+	return (int32_t)(ymodem->resumeAt / YM_PACKET_1K_SIZE) + 1;
+#else
+	(void)ymodem;
+	return 1;
+#endif
+}
+
+/**
+ * @brief  NAKs sent for the same packet before giving up, a window may NAK each packet in flight
+ *
+ */
+static uint16_t ymodem_RetryLimit(ymodem_t *ymodem) {
+#if (YM_WINDOW > 0)
+	if (ymodem->window > 0) {
+		return YM_RX_RETRY_LIMIT * ymodem->window;
+	}
+#endif
+	(void)ymodem;
+	return YM_RX_RETRY_LIMIT;
+}
+
+#if (YM_RESUME > 0)
+/**
+ * @brief  Check digit sent after the resume offset: the sum of its digits, modulo 10
+ *
+ */
+static uint8_t ymodem_ResumeCheck(uint32_t kb) {
+	uint32_t sum = 0;
+
+	while (kb != 0) {
+		sum += kb % 10;
+		kb /= 10;
+	}
+	return '0' + (sum % 10);
+}
+#endif
+
+#if (YM_WINDOW > 0)
+static void ymodem_ResetWindow(ymodem_t *ymodem) {
+	ymodem->window = 0;
+	ymodem->nakSeq = -1;
+	ymodem->eotSeq = 0;
+	ymodem->gapNaked = 0;
+	memset(ymodem->slotPkt, 0, sizeof(ymodem->slotPkt));
+}
+
+/**
+ * @brief  				Handles a data packet when a window was agreed in block 0. Packets ahead of a
+ * 						missing one are kept in the reorder slots, and everything is delivered to the
+ * 						callback in order. The missing packet is NAKed once by sequence number (again
+ * 						on ymodem_LineIdle), a damaged one is NAKed by its own sequence number.
+ *
+ * @return YM_RET_T 	YM_RX_OK for a cumulative ACK, YM_RX_ERROR for one followed by a selective NAK, YM_OK when
+ * 						nothing needs an answer, YM_WRITE_ERR if the callback fails
+ */
+static ym_ret_t ymodem_ProcessWindowPacket(ymodem_t *ymodem) {
+	uint8_t seq = ymodem->packetData[YM_PACKET_SEQNO_INDEX];
+	uint8_t ahead = seq - (uint8_t)ymodem->packetsReceived;
+	uint8_t *data;
+	uint16_t size;
+	int32_t pkt;
+	uint16_t slot;
+
+	if (ymodem_CheckCRC(ymodem) != YM_OK) {
+		/* NAKed by its own sequence number, the sender drops the NAK of a packet it had ACKed */
+		ymodem->nakSeq = seq;
+		return YM_RX_ERROR;
+	}
+	if (ahead >= ymodem->window) {
+		/* Outside the window: a packet of the last window was delivered already and its ACK
+		 * was lost, repeat it. Anything else is stray and only gets the ACK again */
+		if ((uint8_t)((uint8_t)ymodem->packetsReceived - seq) <= ymodem->window) {
+			ymodem->duplicates++;
+		}
+		return YM_RX_OK;
+	}
+	if (ahead > 0) {
+		/* Ahead of a missing packet, keep it */
+		pkt = ymodem->packetsReceived + ahead;
+		slot = pkt % (YM_WINDOW - 1);
+		if (ymodem->slotPkt[slot] != pkt) {
+			memcpy(ymodem->slotData[slot], ymodem->packetData + YM_PACKET_HEADER, ymodem->packetSize);
+			ymodem->slotSize[slot] = ymodem->packetSize;
+			ymodem->slotPkt[slot] = pkt;
+		}
+		if (ymodem->gapNaked != ymodem->packetsReceived) {
+			ymodem->gapNaked = ymodem->packetsReceived;
+			return YM_RX_ERROR;
+		}
+		return YM_OK;
+	}
+
+	data = ymodem->packetData + YM_PACKET_HEADER;
+	size = ymodem->packetSize;
+	while (1) {
+		/* YMODEM_PENDING can not be honoured here, the slots behind it would stall */
+		size = (uint16_t)ymodem_DataLength(ymodem, size);
+#if (YM_DIGEST > 0)
+		ymodem_DigestUpdate(ymodem, data, size);
+#endif
+		if ((size > 0) && (ymodem_FileCallback(ymodem, YMODEM_FILE_CB_DATA, data, size) != YMODEM_OK)) {
+			return YM_WRITE_ERR;
+		}
+		ymodem->fileOffset += size;
+		ymodem->packetsReceived++;
+		slot = ymodem->packetsReceived % (YM_WINDOW - 1);
+		if (ymodem->slotPkt[slot] != ymodem->packetsReceived) {
+			break;
+		}
+		ymodem->slotPkt[slot] = 0;
+		data = ymodem->slotData[slot];
+		size = ymodem->slotSize[slot];
+	}
+	for (slot = 0; slot < YM_WINDOW - 1; slot++) {
+		if (ymodem->slotPkt[slot] > ymodem->packetsReceived) {
+			/* Later packets are kept, the next one is missing as well */
+			ymodem->gapNaked = ymodem->packetsReceived;
+			return YM_RX_ERROR;
+		}
+	}
+	return YM_RX_OK;
+}
+#endif
+
 static void ymodem_WriteSerial(ymodem_t *ymodem){
+	ymodem->idleMs = 0;
 	if (ymodem->serialWriteFxn != NULL){
 		ymodem->serialWriteFxn(ymodem->payloadTx, ymodem->payloadLen);
 	}
 }
 
+#if (YM_SENDER > 0)
+/**
+ * @brief  Initialise YMODEM Tx State
+ * 
+ */
+void ymodem_TxInit(ymodem_tx_t *tx, ymodem_fxn_t SerialWriteFxn) {
+	assert (tx != NULL);
+
+	tx->packetLen		= 0;
+	tx->dataLen			= 0;
+	tx->fileSize		= 0;
+	tx->offset			= 0;
+	tx->seq				= 0;
+	tx->state			= YM_TX_IDLE;
+	tx->retries			= 0;
+	tx->prevC			= 0;
+	tx->streaming		= 0;
+	tx->winOffer		= 0;
+	tx->window			= 0;
+	tx->extIdx			= 0;
+	tx->extPend			= 0;
+	tx->respLen			= 0;
+	tx->nextPkt			= 0;
+	tx->ackedPkt		= 0;
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	tx->largeOffer		= 0;
+	tx->largeSize		= 0;
+#endif
+#if (YM_RESUME > 0)
+	tx->resumeOffer		= 0;
+	tx->resumeDigits	= 0;
+	tx->resumeKb		= 0;
+#endif
+#if (YM_LZ > 0)
+	tx->lzOffer			= 0;
+	tx->lzBits			= 0;
+	tx->lzHist			= 0;
+#endif
+#if (YM_DIGEST > 0)
+	tx->digestOffer		= 0;
+#endif
+	tx->serialWriteFxn	= SerialWriteFxn;
+	tx->nextStatus		= YMODEM_OK;
+	tx->initialized		= YM_INSTANCE_INIT_MASK;
+}
+
+/**
+ * @brief  				Prepares a file to be sent. Block 0 goes out when the receiver asks with 'C',
+ * 						then the data is pulled through ymodem_TxReadCallback.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  fileName		Name of the file, sent in block 0
+ * @param  fileSize		Size of the file in bytes
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_SIZE_ERR if the name does not fit in block 0. With
+ * 						ymodem_TxSetDigest, YMODEM_WRITE_ERR if the file could not be read for its digest
+ */
+ymodem_err_e ymodem_TxStart(ymodem_tx_t *tx, const char *fileName, uint32_t fileSize) {
+	uint8_t sizeStr[YM_FILE_SIZE_LENGTH];
+	uint8_t *ext;
+	uint8_t offer;
+	uint32_t nameLen;
+	uint32_t len;
+	uint32_t i;
+	uint32_t n;
+
+	assert (tx != NULL);
+	assert (tx->initialized == YM_INSTANCE_INIT_MASK);
+
+	nameLen = strlen(fileName);
+	/* Size in decimal, built backwards */
+	i = YM_FILE_SIZE_LENGTH;
+	n = fileSize;
+	do {
+		sizeStr[--i] = '0' + (n % 10);
+		n /= 10;
+	} while (n != 0);
+
+	/* Name, NUL, size, NUL, then the extensions offered */
+	len = nameLen + 1 + (YM_FILE_SIZE_LENGTH - i) + 1;
+	offer = ymodem_TxOffer(tx);
+	if (offer != 0) {
+		/* Marker, capabilities, one parameter each */
+		len += 2 + ((offer & YM_CAP_WINDOW) ? 1 : 0) + ((offer & YM_CAP_LARGE) ? 1 : 0) + ((offer & YM_CAP_LZ) ? 1 : 0);
+#if (YM_DIGEST > 0)
+		len += (offer & YM_CAP_DIGEST) ? (1 + ((YM_DIGEST & YM_DIGEST_CRC32) ? 4 : 0) + ((YM_DIGEST & YM_DIGEST_SHA256) ? 32 : 0)) : 0;
+#endif
+	}
+	if ((nameLen == 0) || (nameLen >= YM_FILE_NAME_LENGTH) || (len > YM_PACKET_1K_SIZE)) {
+		return YMODEM_SIZE_ERR;
+	}
+	memset(tx->packetData + YM_PACKET_HEADER, 0, YM_PACKET_1K_SIZE);
+	memcpy(tx->packetData + YM_PACKET_HEADER, fileName, nameLen);
+	memcpy(tx->packetData + YM_PACKET_HEADER + nameLen + 1, sizeStr + i, YM_FILE_SIZE_LENGTH - i);
+	if (offer != 0) {
+		ext = tx->packetData + YM_PACKET_HEADER + nameLen + 1 + (YM_FILE_SIZE_LENGTH - i) + 1;
+		*ext++ = YM_EXT_MARKER;
+		*ext++ = offer;
+		if (offer & YM_CAP_WINDOW) {
+			*ext++ = tx->winOffer;
+		}
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+		if (offer & YM_CAP_LARGE) {
+			*ext++ = (uint8_t)(tx->largeOffer / 1024);
+		}
+#endif
+#if (YM_LZ > 0)
+		if (offer & YM_CAP_LZ) {
+			*ext++ = tx->lzOffer;
+		}
+#endif
+#if (YM_DIGEST > 0)
+		if (offer & YM_CAP_DIGEST) {
+			tx->fileSize = fileSize;
+			if ((ext = ymodem_TxDigest(tx, ext)) == NULL) {
+				return YMODEM_WRITE_ERR;
+			}
+		}
+#endif
+	}
+	tx->seq = 0;
+	ymodem_TxBuildPacket(tx, (len > YM_PACKET_SIZE) ? YM_PACKET_1K_SIZE : YM_PACKET_SIZE);
+
+	tx->fileSize	= fileSize;
+	tx->offset		= 0;
+	tx->dataLen		= 0;
+	tx->retries		= 0;
+	tx->prevC		= 0;
+	tx->streaming	= 0;
+	ymodem_TxExtReset(tx);
+	tx->extIdx		= 0;
+	tx->respLen		= 0;
+#if (YM_LZ > 0)
+	/* Both sides start the file with an empty history */
+	tx->lzHist		= 0;
+	memset(tx->lzHash, 0xFF, sizeof(tx->lzHash));
+#endif
+	tx->state		= YM_TX_WAIT_START;
+	tx->nextStatus	= YMODEM_OK;
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Handles a byte from the YMODEM Receiver ('C', ACK, NAK or CA) and sends
+ * 						whatever comes next through the serial write function.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  c			A byte from the YMODEM Receiver
+ * @return YMODEM_T 	YMODEM_TX_PENDING when something was sent, YMODEM_COMPLETE once the empty
+ * 						block 0 is ACKed, YMODEM_ABORTED on a double CA or when giving up.
+ */
+ymodem_err_e ymodem_TxReceiveByte(ymodem_tx_t *tx, uint8_t c) {
+	ymodem_err_e ret = YMODEM_OK;
+
+	assert (tx != NULL);
+	assert (tx->initialized == YM_INSTANCE_INIT_MASK);
+
+	/* Return status if just closed connection */
+	if (tx->nextStatus != YMODEM_OK) return tx->nextStatus;
+
+	if ((c == CA) && (tx->prevC == CA)) {
+		tx->nextStatus = YMODEM_ABORTED;
+		tx->state = YM_TX_IDLE;
+		return YMODEM_ABORTED;
+	}
+	tx->prevC = c;
+
+	switch (tx->state) {
+		case YM_TX_WAIT_START:
+			if ((c == CRC16) || (c == CRCG)) {
+				/* 'G' selects YMODEM-G for the whole file */
+				tx->streaming = (c == CRCG);
+				tx->state = YM_TX_WAIT_NAME_ACK;
+				ret = ymodem_TxSend(tx);
+			}
+			break;
+		case YM_TX_WAIT_NAME_ACK:
+			if (tx->streaming && (c == CRCG)) {
+				/* YMODEM-G answers block 0 with 'G' only, start streaming */
+				tx->seq = 1;
+				ret = ymodem_TxNextPacket(tx);
+			} else if (c == ACK) {
+				tx->extIdx = 0;
+				tx->state = YM_TX_WAIT_DATA_C;
+			} else if ((c == YM_EXT_MARKER) && (ymodem_TxOffer(tx) != 0)) {
+				/* The receiver repeats its extension answer without the ACK, the ACK was lost */
+				tx->extIdx = 1;
+				tx->state = YM_TX_WAIT_DATA_C;
+			} else if (c == NAK) {
+				ret = ymodem_TxRetry(tx);
+			}
+			break;
+		case YM_TX_WAIT_DATA_C:
+			/* Answer to the extensions offered: marker, capabilities, their parameters. Anything
+			 * else before the 'C' is a damaged answer (extIdx 4), the receiver repeats it */
+			if ((ymodem_TxOffer(tx) != 0) && (c == YM_EXT_MARKER) && ((tx->extIdx == 0) || (tx->extIdx == 4))) {
+				tx->extIdx = 1;
+			} else if ((tx->extIdx == 1) && (c != 0) && ((c & ~ymodem_TxOffer(tx)) == 0)) {
+				/* The parameters of the capabilities accepted follow, in bit order */
+				tx->extPend = c;
+				tx->extIdx = 2;
+			} else if ((tx->extIdx == 2) && ymodem_TxExtParam(tx, c)) {
+				if (tx->extPend == 0) {
+					tx->extIdx = 3;
+				}
+			} else if ((c == CRC16) && (tx->extIdx == 4)) {
+				tx->extIdx = 0;
+#if (YM_RESUME > 0)
+			} else if ((c == NAK) && tx->resumeOffer && (tx->extIdx != 3)) {
+				/* Starting over at 0 would not match a receiver that resumes. Send block 0
+				 * again, the receiver answers it again until the data starts */
+				ymodem_TxExtReset(tx);
+				tx->extIdx = 0;
+				tx->state = YM_TX_WAIT_NAME_ACK;
+				ret = ymodem_TxRetry(tx);
+#endif
+			} else if (((c == CRC16) && (tx->extIdx != 1) && (tx->extIdx != 2)) ||
+					((c == NAK) && ((tx->extIdx == 0) || (tx->extIdx == 4)))) {
+				/* A NAK here is a receiver that timed out waiting for the data */
+				tx->seq = 1;
+#if (YM_RESUME > 0)
+				/* Sequence numbers go on as if the part skipped had been sent in 1K packets */
+				tx->offset = tx->resumeKb * YM_PACKET_1K_SIZE;
+				tx->seq = (uint8_t)(tx->resumeKb + 1);
+#endif
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+				if (tx->window > 0) {
+					/* Window packets are 1K, the same choice as the receiver */
+					tx->largeSize = 0;
+				}
+#endif
+#if (YM_LZ > 0)
+				if (tx->window > 0) {
+					/* Not with a window, the same choice as the receiver */
+					tx->lzBits = 0;
+				}
+#endif
+				if ((tx->window > 0) && (tx->offset < tx->fileSize)) {
+					tx->retries = 0;
+					tx->ackedPkt = tx->offset / YM_PACKET_1K_SIZE + 1;
+					tx->nextPkt = tx->ackedPkt + 1;
+					tx->state = YM_TX_WINDOW;
+					ret = ymodem_TxWindowSend(tx, tx->ackedPkt);
+				} else {
+					ret = ymodem_TxNextPacket(tx);
+				}
+			} else if (ymodem_TxOffer(tx) != 0) {
+				ymodem_TxExtReset(tx);
+				tx->extIdx = 4;
+			}
+			break;
+		case YM_TX_WINDOW:
+			if ((tx->respLen == 0) && (c == CRC16) && (tx->ackedPkt == tx->offset / YM_PACKET_1K_SIZE + 1)) {
+				/* The receiver repeats its answer to block 0 until the first packet arrives */
+				ret = ymodem_TxWindowAnswer(tx, NAK, (uint8_t)tx->ackedPkt);
+			} else if (ymodem_TxWindowByte(tx, c)) {
+				ret = ymodem_TxWindowAnswer(tx, tx->resp[0], tx->resp[1]);
+			}
+			break;
+		case YM_TX_WAIT_DATA_ACK:
+			if (c == ACK) {
+				tx->offset += tx->dataLen;
+				tx->seq++;
+				ret = ymodem_TxNextPacket(tx);
+			} else if (c == NAK) {
+				ret = ymodem_TxRetry(tx);
+			}
+			break;
+		case YM_TX_WAIT_EOT_ACK:
+			if (tx->window > 0) {
+				/* The EOT takes the sequence after the last packet, other answers are stale */
+				if ((tx->respLen == 0) && (c == CRC16)) {
+					/* The receiver polls for block 0, its answer to the EOT was lost */
+					tx->window = 0;
+					tx->state = YM_TX_WAIT_END_C;
+					ret = ymodem_TxReceiveByte(tx, c);
+				} else if (ymodem_TxWindowByte(tx, c) && (tx->resp[1] == (uint8_t)(ymodem_TxPackets(tx) + 1))) {
+					if (tx->resp[0] == ACK) {
+						tx->window = 0;
+						tx->state = YM_TX_WAIT_END_C;
+					} else {
+						ret = ymodem_TxRetry(tx);
+					}
+				}
+			} else if (c == ACK) {
+				tx->state = YM_TX_WAIT_END_C;
+			} else if (c == NAK) {
+				/* Some receivers NAK the first EOT */
+				ret = ymodem_TxRetry(tx);
+			}
+			break;
+		case YM_TX_WAIT_END_C:
+			if ((c == CRC16) || (c == CRCG)) {
+				/* Empty block 0 closes the batch */
+				memset(tx->packetData + YM_PACKET_HEADER, 0, YM_PACKET_SIZE);
+				tx->seq = 0;
+				tx->retries = 0;
+				ymodem_TxBuildPacket(tx, YM_PACKET_SIZE);
+				tx->state = YM_TX_WAIT_END_ACK;
+				ret = ymodem_TxSend(tx);
+			}
+			break;
+		case YM_TX_WAIT_END_ACK:
+			if (c == ACK) {
+				tx->state = YM_TX_IDLE;
+				tx->nextStatus = YMODEM_COMPLETE;
+				ret = YMODEM_COMPLETE;
+			} else if ((c == NAK) || (c == CRC16)) {
+				/* A 'C' is the receiver still polling for block 0 */
+				ret = ymodem_TxRetry(tx);
+			}
+			break;
+		default:
+			break;
+	}
+	return ret;
+}
+
+/**
+ * @brief  				Sends the next data packet of a YMODEM-G stream, or of the window agreed in
+ * 						block 0, where the sender does not wait for each ACK. Call it whenever the
+ * 						serial port can take another packet, it does nothing in the ACKed protocol.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @return YMODEM_T 	YMODEM_TX_PENDING when a packet or the EOT was sent, otherwise YMODEM_OK
+ * 						or the closing status.
+ */
+ymodem_err_e ymodem_TxPoll(ymodem_tx_t *tx) {
+	assert (tx != NULL);
+	assert (tx->initialized == YM_INSTANCE_INIT_MASK);
+
+	if (tx->nextStatus != YMODEM_OK) return tx->nextStatus;
+	if (tx->state == YM_TX_WINDOW) {
+		/* Fill the window */
+		if ((tx->nextPkt < tx->ackedPkt + tx->window) && (tx->nextPkt <= ymodem_TxPackets(tx))) {
+			return ymodem_TxWindowSend(tx, tx->nextPkt++);
+		}
+		return YMODEM_OK;
+	}
+	if (tx->state != YM_TX_STREAM) {
+		return YMODEM_OK;
+	}
+	/* No ACK in YMODEM-G, the previous packet counts as delivered */
+	tx->offset += tx->dataLen;
+	tx->seq++;
+	return ymodem_TxNextPacket(tx);
+}
+
+/**
+ * @brief  				Offers a sliding window in block 0 of the next files. If the receiver accepts,
+ * 						up to that many packets are in flight, it ACKs cumulatively and NAKs missing
+ * 						packets by sequence number. 0 keeps stop-and-wait.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  window		Packets in flight, at most 127
+ */
+void ymodem_TxSetWindow(ymodem_tx_t *tx, uint8_t window) {
+	assert (tx != NULL);
+
+	tx->winOffer = (window > 127) ? 127 : window;
+	if (tx->winOffer == 1) {
+		tx->winOffer = 0;
+	}
+}
+
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+/**
+ * @brief  				Offers large blocks in block 0 of the next files. If the receiver accepts, the
+ * 						data goes out in packets of that size (started by STX_LARGE) while they are
+ * 						full. A window, when also agreed, keeps 1K packets. 0 keeps 1K packets.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  size			Block size, a multiple of 1024 up to YM_PACKET_MAX_SIZE
+ */
+void ymodem_TxSetLargeBlocks(ymodem_tx_t *tx, uint16_t size) {
+	assert (tx != NULL);
+
+	size = (size > YM_PACKET_MAX_SIZE) ? YM_PACKET_MAX_SIZE : (size & ~(YM_PACKET_1K_SIZE - 1));
+	tx->largeOffer = (size > YM_PACKET_1K_SIZE) ? size : 0;
+}
+#endif
+
+#if (YM_RESUME > 0)
+/**
+ * @brief  				Offers resume in block 0 of the next files. A receiver holding part of the file
+ * 						answers with the offset it resumes from, and the data is sent from there on.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  enable		1 to offer resume, 0 to always send the whole file
+ */
+void ymodem_TxSetResume(ymodem_tx_t *tx, uint8_t enable) {
+	assert (tx != NULL);
+
+	tx->resumeOffer = (enable != 0);
+}
+#endif
+
+#if (YM_LZ > 0)
+/**
+ * @brief  				Offers LZ compression in block 0 of the next files. If the receiver accepts, each
+ * 						data packet carries as much of the file as it holds compressed, or the file data
+ * 						as it is when it does not compress. Not used when a window is agreed.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  windowBits	History window, 8 to YM_LZ_WINDOW_BITS bits. 0 sends the file as it is
+ */
+void ymodem_TxSetCompression(ymodem_tx_t *tx, uint8_t windowBits) {
+	assert (tx != NULL);
+
+	if (windowBits == 0) {
+		tx->lzOffer = 0;
+		return;
+	}
+	tx->lzOffer = (windowBits < 8) ? 8 : ((windowBits > YM_LZ_WINDOW_BITS) ? YM_LZ_WINDOW_BITS : windowBits);
+}
+#endif
+
+#if (YM_DIGEST > 0)
+/**
+ * @brief  				Gives the digest of the next files in block 0 (the ones built in with YM_DIGEST), so
+ * 						the receiver can check what it got without reading it back. ymodem_TxStart reads
+ * 						the whole file once through ymodem_TxReadCallback to compute it.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  enable		1 to give the digest, 0 not to
+ */
+void ymodem_TxSetDigest(ymodem_tx_t *tx, uint8_t enable) {
+	assert (tx != NULL);
+
+	tx->digestOffer = (enable != 0);
+}
+#endif
+
+/**
+ * @brief  Cancels the transfer with a double CA
+ * 
+ */
+ymodem_err_e ymodem_TxAbort(ymodem_tx_t *tx) {
+	uint8_t cancel[2] = {CA, CA};
+
+	assert (tx != NULL);
+	assert (tx->initialized == YM_INSTANCE_INIT_MASK);
+
+	if (tx->serialWriteFxn != NULL) {
+		tx->serialWriteFxn(cancel, sizeof(cancel));
+	}
+	tx->state = YM_TX_IDLE;
+	tx->nextStatus = YMODEM_ABORTED;
+	return YMODEM_ABORTED;
+}
+
+static ymodem_err_e ymodem_TxSend(ymodem_tx_t *tx) {
+	if (tx->serialWriteFxn != NULL) {
+		tx->serialWriteFxn(tx->packetData, tx->packetLen);
+	}
+	return YMODEM_TX_PENDING;
+}
+
+static ymodem_err_e ymodem_TxRetry(ymodem_tx_t *tx) {
+	if (++tx->retries > YM_TX_RETRY_LIMIT) {
+		return ymodem_TxAbort(tx);
+	}
+	return ymodem_TxSend(tx);
+}
+
+/**
+ * @brief  				Reads and sends the packet at the current offset, or EOT at the end of the
+ * 						file. 1K packets are used, and a 128 byte one when no more than 128 bytes are left.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @return YMODEM_T 	YMODEM_TX_PENDING, or YMODEM_ABORTED if the read callback failed
+ */
+static ymodem_err_e ymodem_TxNextPacket(ymodem_tx_t *tx) {
+	ymodem_err_e ret;
+
+	tx->retries = 0;
+	if (tx->offset >= tx->fileSize) {
+		tx->packetData[0] = EOT;
+		tx->packetLen = 1;
+		tx->dataLen = 0;
+		tx->respLen = 0;
+		tx->state = YM_TX_WAIT_EOT_ACK;
+		return ymodem_TxSend(tx);
+	}
+	ret = ymodem_TxLoadPacket(tx, tx->offset, tx->seq);
+	if (ret != YMODEM_OK) {
+		return ret;
+	}
+	tx->state = (tx->streaming) ? YM_TX_STREAM : YM_TX_WAIT_DATA_ACK;
+	return ymodem_TxSend(tx);
+}
+
+/**
+ * @brief  				Reads the file at offset into packetData and builds the packet around it.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  offset		Position in the file, below the file size
+ * @param  seq			Sequence number of the packet
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_ABORTED if the read callback failed
+ */
+static ymodem_err_e ymodem_TxLoadPacket(ymodem_tx_t *tx, uint32_t offset, uint8_t seq) {
+	uint32_t left = tx->fileSize - offset;
+	uint16_t size;
+
+#if (YM_LZ > 0)
+	if (tx->lzBits > 0) {
+		return ymodem_TxLzLoadPacket(tx, offset, seq);
+	}
+#endif
+	size = (left > YM_PACKET_SIZE) ? YM_PACKET_1K_SIZE : YM_PACKET_SIZE;
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	/* Large blocks while they are full, the tail goes in 1K and 128 byte packets */
+	if ((tx->largeSize > 0) && (left >= tx->largeSize)) {
+		size = tx->largeSize;
+	}
+#endif
+	tx->dataLen = (left < size) ? left : size;
+	if (ymodem_TxReadCallback(tx, offset, tx->packetData + YM_PACKET_HEADER, tx->dataLen) != tx->dataLen) {
+		return ymodem_TxAbort(tx);
+	}
+	memset(tx->packetData + YM_PACKET_HEADER + tx->dataLen, CPMEOF, size - tx->dataLen);
+	tx->seq = seq;
+	ymodem_TxBuildPacket(tx, size);
+	return YMODEM_OK;
+}
+
+#if (YM_LZ > 0)
+/**
+ * @brief  				Compresses the file from offset into packetData and builds the packet around it.
+ * 						The packet is the smallest of 128, 1K or the large block size that holds it.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  offset		Position in the file, below the file size
+ * @param  seq			Sequence number of the packet
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_ABORTED if the read callback failed
+ */
+static ymodem_err_e ymodem_TxLzLoadPacket(ymodem_tx_t *tx, uint32_t offset, uint8_t seq) {
+	uint8_t *out = tx->packetData + YM_PACKET_HEADER;
+	uint32_t left = tx->fileSize - offset;
+	uint32_t inLen = (left < YM_LZ_INPUT) ? left : YM_LZ_INPUT;
+	uint32_t consumed;
+	uint32_t stored;
+	uint16_t cap = YM_PACKET_1K_SIZE;
+	uint16_t count;
+	uint16_t size;
+
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	if (tx->largeSize > 0) {
+		cap = tx->largeSize;
+	}
+#endif
+	if (ymodem_TxReadCallback(tx, offset, tx->lzBuf + tx->lzHist, inLen) != inLen) {
+		return ymodem_TxAbort(tx);
+	}
+	count = ymodem_TxLzEncode(tx, inLen, out + 2, cap - 2, &consumed);
+	stored = (inLen < (uint32_t)(cap - 2)) ? inLen : (uint32_t)(cap - 2);
+	if ((consumed < stored) || (count >= consumed)) {
+		/* Does not compress, send the file data as it is */
+		memcpy(out + 2, tx->lzBuf + tx->lzHist, stored);
+		consumed = stored;
+		count = (uint16_t)stored | YM_LZ_STORED;
+	}
+	out[0] = count & 0xFF;
+	out[1] = count >> 8;
+	count = (count & ~YM_LZ_STORED) + 2;
+	size = (count <= YM_PACKET_SIZE) ? YM_PACKET_SIZE : ((count <= YM_PACKET_1K_SIZE) ? YM_PACKET_1K_SIZE : cap);
+	memset(out + count, CPMEOF, size - count);
+	ymodem_TxLzSlide(tx, consumed);
+	tx->dataLen = (uint16_t)consumed;
+	tx->seq = seq;
+	ymodem_TxBuildPacket(tx, size);
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Compresses the inLen bytes after the history in lzBuf, as far as the tokens fit
+ * 						in cap bytes. Each position is matched against the last one with the same hash.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  inLen		File bytes in lzBuf after the history
+ * @param  out			Where to write the tokens
+ * @param  cap			Room in out
+ * @param  consumed		File bytes covered by the tokens
+ * @return uint16_t		Bytes of tokens written
+ */
+static uint16_t ymodem_TxLzEncode(ymodem_tx_t *tx, uint32_t inLen, uint8_t *out, uint16_t cap, uint32_t *consumed) {
+	const uint8_t *buf = tx->lzBuf;
+	const uint32_t maxLen = (1 << (16 - tx->lzBits)) - 1 + YM_LZ_MIN_MATCH;
+	uint32_t cur = tx->lzHist;
+	uint32_t end = tx->lzHist + inLen;
+	uint32_t cand;
+	uint32_t len;
+	uint32_t h;
+	uint16_t o = 0;
+	uint16_t flagPos = 0;
+	uint8_t bit = 8;
+
+	while (cur < end) {
+		len = 0;
+		if (cur + YM_LZ_MIN_MATCH <= end) {
+			h = ((buf[cur] << 16) | (buf[cur + 1] << 8) | buf[cur + 2]) * 2654435761u >> (32 - YM_LZ_HASH_BITS);
+			cand = tx->lzHash[h];
+			tx->lzHash[h] = (uint16_t)cur;
+			if ((cand < cur) && (cur - cand <= (1u << tx->lzBits))) {
+				while ((len < maxLen) && (cur + len < end) && (buf[cand + len] == buf[cur + len])) {
+					len++;
+				}
+			}
+		}
+		if (len < YM_LZ_MIN_MATCH) {
+			len = 0;
+		}
+		if (o + ((bit == 8) ? 1 : 0) + ((len > 0) ? 2 : 1) > cap) {
+			break;
+		}
+		if (bit == 8) {
+			flagPos = o;
+			out[o++] = 0;
+			bit = 0;
+		}
+		if (len > 0) {
+			out[flagPos] |= 1 << bit;
+			h = ((len - YM_LZ_MIN_MATCH) << tx->lzBits) | (cur - cand - 1);
+			out[o++] = h & 0xFF;
+			out[o++] = (h >> 8) & 0xFF;
+			/* Positions inside the match are candidates for later ones */
+			for (cand = cur + 1, cur += len; (cand < cur) && (cand + YM_LZ_MIN_MATCH <= end); cand++) {
+				tx->lzHash[((buf[cand] << 16) | (buf[cand + 1] << 8) | buf[cand + 2]) * 2654435761u >> (32 - YM_LZ_HASH_BITS)] = (uint16_t)cand;
+			}
+		} else {
+			out[o++] = buf[cur++];
+		}
+		bit++;
+	}
+	*consumed = cur - tx->lzHist;
+	return o;
+}
+
+/**
+ * @brief  				Moves the consumed bytes into the history, keeping the last window of it at the
+ * 						start of lzBuf, and moves the hash positions with it.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  consumed		File bytes sent in the packet
+ */
+static void ymodem_TxLzSlide(ymodem_tx_t *tx, uint32_t consumed) {
+	uint32_t total = tx->lzHist + consumed;
+	uint32_t keep = (total < (1u << tx->lzBits)) ? total : (1u << tx->lzBits);
+	uint32_t shift = total - keep;
+	uint32_t i;
+
+	memmove(tx->lzBuf, tx->lzBuf + shift, keep);
+	tx->lzHist = (uint16_t)keep;
+	for (i = 0; i < (1u << YM_LZ_HASH_BITS); i++) {
+		tx->lzHash[i] = ((tx->lzHash[i] == 0xFFFF) || (tx->lzHash[i] < shift)) ? 0xFFFF : (uint16_t)(tx->lzHash[i] - shift);
+	}
+}
+#endif
+
+/**
+ * @brief  Number of data packets of the file in window mode, all 1K but a short last one
+ *
+ */
+static uint32_t ymodem_TxPackets(ymodem_tx_t *tx) {
+	return (tx->fileSize + YM_PACKET_1K_SIZE - 1) / YM_PACKET_1K_SIZE;
+}
+
+/**
+ * @brief  				Sends data packet pkt (1 for the first one) in window mode. Retransmissions
+ * 						read the file again, only one packet is kept in ymodem_tx_t.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  pkt			Packet number
+ * @return YMODEM_T 	YMODEM_TX_PENDING, or YMODEM_ABORTED if the read callback failed
+ */
+static ymodem_err_e ymodem_TxWindowSend(ymodem_tx_t *tx, uint32_t pkt) {
+	ymodem_err_e ret;
+
+	ret = ymodem_TxLoadPacket(tx, (pkt - 1) * YM_PACKET_1K_SIZE, (uint8_t)pkt);
+	if (ret != YMODEM_OK) {
+		return ret;
+	}
+	return ymodem_TxSend(tx);
+}
+
+/**
+ * @brief  				Collects a window answer, ACK or NAK followed by the sequence number and its
+ * 						complement. A damaged answer is dropped, the receiver repeats it on a timeout.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  c			Byte from the receiver
+ * @return uint8_t		1 when a whole answer is in resp[], otherwise 0
+ */
+static uint8_t ymodem_TxWindowByte(ymodem_tx_t *tx, uint8_t c) {
+	if (tx->respLen == 0) {
+		if ((c == ACK) || (c == NAK)) {
+			tx->resp[tx->respLen++] = c;
+		}
+		return 0;
+	}
+	tx->resp[tx->respLen++] = c;
+	if (tx->respLen < 3) {
+		return 0;
+	}
+	tx->respLen = 0;
+	if ((tx->resp[1] ^ tx->resp[2]) == 0xFF) {
+		return 1;
+	}
+	if ((c == ACK) || (c == NAK)) {
+		/* Resynchronize on the last byte */
+		tx->resp[tx->respLen++] = c;
+	}
+	return 0;
+}
+
+/**
+ * @brief  				Handles an ACK or NAK with its sequence number in window mode. ACK n confirms
+ * 						every packet up to n, NAK n only asks for n again (the receiver sends it after a
+ * 						cumulative ACK). Once the whole file is confirmed the EOT goes out.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  cmd			ACK or NAK
+ * @param  seq			Sequence number that came with it
+ * @return YMODEM_T 	YMODEM_TX_PENDING when something was sent, otherwise YMODEM_OK or YMODEM_ABORTED
+ */
+static ymodem_err_e ymodem_TxWindowAnswer(ymodem_tx_t *tx, uint8_t cmd, uint8_t seq) {
+	uint8_t ahead = seq - (uint8_t)tx->ackedPkt;
+	uint32_t pkt = tx->ackedPkt + ahead;
+
+	if ((ahead > tx->window) || (pkt > tx->nextPkt)) {
+		/* Stale answer for a packet confirmed already */
+		return YMODEM_OK;
+	}
+	if (cmd == ACK) {
+		if (pkt == tx->nextPkt) {
+			return YMODEM_OK;
+		}
+		tx->ackedPkt = pkt + 1;
+		tx->retries = 0;
+	} else if (pkt < tx->nextPkt) {
+		/* Answers to a window of packets may still name it after it was sent again */
+		if (++tx->retries > YM_TX_RETRY_LIMIT * tx->window) {
+			return ymodem_TxAbort(tx);
+		}
+		return ymodem_TxWindowSend(tx, pkt);
+	}
+	if (tx->ackedPkt > ymodem_TxPackets(tx)) {
+		/* Whole file confirmed */
+		tx->offset = tx->fileSize;
+		return ymodem_TxNextPacket(tx);
+	}
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  Block 0 extensions offered to the receiver
+ *
+ */
+static uint8_t ymodem_TxOffer(ymodem_tx_t *tx) {
+	uint8_t offer = (tx->winOffer > 0) ? YM_CAP_WINDOW : 0;
+
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	if (tx->largeOffer > 0) {
+		offer |= YM_CAP_LARGE;
+	}
+#endif
+#if (YM_RESUME > 0)
+	if (tx->resumeOffer) {
+		offer |= YM_CAP_RESUME;
+	}
+#endif
+#if (YM_LZ > 0)
+	if (tx->lzOffer > 0) {
+		offer |= YM_CAP_LZ;
+	}
+#endif
+#if (YM_DIGEST > 0)
+	if (tx->digestOffer) {
+		offer |= YM_CAP_DIGEST;
+	}
+#endif
+	return offer;
+}
+
+/**
+ * @brief  				Reads a byte of the parameters in the receiver's extension answer.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  c			Byte from the receiver
+ * @return uint8_t		1 if it is valid for the parameter being read, 0 for a damaged answer
+ */
+static uint8_t ymodem_TxExtParam(ymodem_tx_t *tx, uint8_t c) {
+	if (tx->extPend & YM_CAP_WINDOW) {
+		if (c < 2) {
+			return 0;
+		}
+		tx->window = (c < tx->winOffer) ? c : tx->winOffer;
+		tx->extPend &= ~YM_CAP_WINDOW;
+		return 1;
+	}
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	if (tx->extPend & YM_CAP_LARGE) {
+		if (c < 2) {
+			return 0;
+		}
+		tx->largeSize = ((c < tx->largeOffer / 1024) ? c : (tx->largeOffer / 1024)) * 1024;
+		tx->extPend &= ~YM_CAP_LARGE;
+		return 1;
+	}
+#endif
+#if (YM_RESUME > 0)
+	if (tx->extPend & YM_CAP_RESUME) {
+		if (!ISVALIDDEC(c)) {
+			return 0;
+		}
+		if (tx->resumeDigits < YM_RESUME_DIGITS) {
+			tx->resumeKb = tx->resumeKb * 10 + CONVERTDEC(c);
+			tx->resumeDigits++;
+			return 1;
+		}
+		/* Check digit, and the offset can not be past the end of the file */
+		if ((c != ymodem_ResumeCheck(tx->resumeKb)) || (tx->resumeKb > tx->fileSize / YM_PACKET_1K_SIZE)) {
+			return 0;
+		}
+		tx->extPend &= ~YM_CAP_RESUME;
+		return 1;
+	}
+#endif
+#if (YM_LZ > 0)
+	if (tx->extPend & YM_CAP_LZ) {
+		if ((c < 8) || (c > tx->lzOffer)) {
+			return 0;
+		}
+		tx->lzBits = c;
+		tx->extPend &= ~YM_CAP_LZ;
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+/**
+ * @brief  Forgets what was agreed in the receiver's extension answer
+ *
+ */
+static void ymodem_TxExtReset(ymodem_tx_t *tx) {
+	tx->window = 0;
+	tx->extPend = 0;
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	tx->largeSize = 0;
+#endif
+#if (YM_RESUME > 0)
+	tx->resumeDigits = 0;
+	tx->resumeKb = 0;
+#endif
+#if (YM_LZ > 0)
+	tx->lzBits = 0;
+#endif
+}
+
+#if (YM_DIGEST > 0)
+/**
+ * @brief  				Reads the file through ymodem_TxReadCallback and writes its digest parameters to
+ * 						block 0. The payload of packetData after ext is used to read into.
+ *
+ * @param  tx			Ymodem sender instance, fileSize set
+ * @param  ext			Where the parameters go in block 0
+ * @return uint8_t*		Position after them, NULL if the file could not be read
+ */
+static uint8_t *ymodem_TxDigest(ymodem_tx_t *tx, uint8_t *ext) {
+	uint8_t *buf = ext + 1 + 4 + 32;
+	uint32_t room = (uint32_t)(tx->packetData + YM_PACKET_HEADER + YM_PACKET_1K_SIZE - buf);
+	uint32_t offset;
+	uint32_t n;
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+	uint32_t crc = 0;
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+	ymodem_sha256_t sha;
+
+	ymodem_Sha256Init(&sha);
+#endif
+	if (room == 0) {
+		return NULL;
+	}
+	for (offset = 0; offset < tx->fileSize; offset += n) {
+		n = ((tx->fileSize - offset) < room) ? (tx->fileSize - offset) : room;
+		if (ymodem_TxReadCallback(tx, offset, buf, n) != n) {
+			return NULL;
+		}
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+		crc = ymodem_Crc32(crc, buf, n);
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+		ymodem_Sha256Update(&sha, buf, n);
+#endif
+	}
+	memset(buf, 0, room);
+	*ext++ = YM_DIGEST;
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+	*ext++ = (uint8_t)crc;
+	*ext++ = (uint8_t)(crc >> 8);
+	*ext++ = (uint8_t)(crc >> 16);
+	*ext++ = (uint8_t)(crc >> 24);
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+	ymodem_Sha256Final(&sha, ext);
+	ext += 32;
+#endif
+	return ext;
+}
+#endif
+
+/**
+ * @brief  				Fills in the header and CRC around the payload already in packetData.
+ *
+ * @param  tx			Ymodem sender instance.
+ * @param  size			Payload size, YM_PACKET_SIZE, YM_PACKET_1K_SIZE or the large block size
+ */
+static void ymodem_TxBuildPacket(ymodem_tx_t *tx, uint16_t size) {
+	uint16_t crc;
+
+	tx->packetData[0] = (size == YM_PACKET_SIZE) ? SOH : ((size == YM_PACKET_1K_SIZE) ? STX : STX_LARGE);
+	tx->packetData[YM_PACKET_SEQNO_INDEX] = tx->seq;
+	tx->packetData[YM_PACKET_SEQNO_COMP_INDEX] = tx->seq ^ 0xFF;
+	crc = ymodem_Crc16(NULL, 0, tx->packetData + YM_PACKET_HEADER, size);
+	tx->packetData[YM_PACKET_HEADER + size] = crc >> 8;
+	tx->packetData[YM_PACKET_HEADER + size + 1] = crc & 0xFF;
+	tx->packetLen = size + YM_PACKET_OVERHEAD;
+}
+#endif
+
 static uint32_t Str2Int(uint8_t *inputstr, uint32_t *intnum) {
 	uint32_t i = 0, res = 0;
 	uint32_t val = 0;
@@ -438,33 +2695,856 @@ static uint32_t Str2Int(uint8_t *inputstr, uint32_t *intnum) {
 	return res;
 }
 
-static uint16_t crc_update(uint16_t crc_in, int incr)
+/**
+ * @brief  				Reads a space separated octal field of the block 0 metadata.
+ *
+ * @param  inputstr		Position after the previous field
+ * @param  end			End of the metadata
+ * @param  intnum		Value read, 0 if the field is absent
+ * @return uint8_t*		Position after the field
+ */
+static uint8_t *Str2Oct(uint8_t *inputstr, uint8_t *end, uint32_t *intnum) {
+	uint32_t val = 0;
+
+	if ((inputstr < end) && (*inputstr == ' ')) {
+		inputstr++;
+		while ((inputstr < end) && (*inputstr >= '0') && (*inputstr <= '7')) {
+			val = (val << 3) | (*inputstr - '0');
+			inputstr++;
+		}
+	}
+	*intnum = val;
+	return inputstr;
+}
+
+/**
+ * @brief  				Swaps the two bytes of a 16 bit value.
+ *
+ * @param  val			Value to swap, evaluated once
+ * @return uint16_t		The swapped value
+ */
+static uint16_t Swap16(uint16_t val) {
+	return (uint16_t)((val >> 8) | (val << 8));
+}
+
+#if (YM_CRC_TABLE_SIZE == 256)
+/** CRC-16/XMODEM lookup table, one entry per byte value **/
+static const uint16_t crc16Table[256] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+	0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+	0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+	0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+	0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+	0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+	0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+	0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+	0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+	0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+	0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+	0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+	0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+	0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+	0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+	0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+	0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+	0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+	0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+	0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+	0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+	0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+	0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+	0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+	0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+	0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+	0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+	0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+	0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+	0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+	0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+};
+#elif (YM_CRC_TABLE_SIZE == 16)
+/** CRC-16/XMODEM lookup table, one entry per nibble value **/
+static const uint16_t crc16Table[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+#else
+#error "YM_CRC_TABLE_SIZE must be 16 or 256"
+#endif
+
+#if (YM_CRC_SLICE > 0) && ((YM_CRC_SLICE != 8 && YM_CRC_SLICE != 16) || (YM_CRC_TABLE_SIZE != 256))
+#error "YM_CRC_SLICE must be 0, 8 or 16, and needs YM_CRC_TABLE_SIZE == 256"
+#endif
+
+#if (YM_CRC_SLICE > 0)
+/** Slicing tables, crc16Slice[k][b] is the CRC of byte b followed by k zero bytes.
+ *  Row 0 is crc16Table, row k is row k-1 run through one more zero byte **/
+static const uint16_t crc16Slice[YM_CRC_SLICE][256] = {
+	{	/* 0 */
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+		0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+		0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+		0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+		0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+		0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+		0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+		0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+		0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+		0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+		0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+		0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+		0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+		0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+		0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+		0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+		0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+		0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+		0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+		0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+		0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+		0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+		0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+		0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+		0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+		0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+		0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+		0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+		0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+		0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+		0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+		0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+	},
+	{	/* 1 */
+		0x0000, 0x3331, 0x6662, 0x5553, 0xCCC4, 0xFFF5, 0xAAA6, 0x9997,
+		0x89A9, 0xBA98, 0xEFCB, 0xDCFA, 0x456D, 0x765C, 0x230F, 0x103E,
+		0x0373, 0x3042, 0x6511, 0x5620, 0xCFB7, 0xFC86, 0xA9D5, 0x9AE4,
+		0x8ADA, 0xB9EB, 0xECB8, 0xDF89, 0x461E, 0x752F, 0x207C, 0x134D,
+		0x06E6, 0x35D7, 0x6084, 0x53B5, 0xCA22, 0xF913, 0xAC40, 0x9F71,
+		0x8F4F, 0xBC7E, 0xE92D, 0xDA1C, 0x438B, 0x70BA, 0x25E9, 0x16D8,
+		0x0595, 0x36A4, 0x63F7, 0x50C6, 0xC951, 0xFA60, 0xAF33, 0x9C02,
+		0x8C3C, 0xBF0D, 0xEA5E, 0xD96F, 0x40F8, 0x73C9, 0x269A, 0x15AB,
+		0x0DCC, 0x3EFD, 0x6BAE, 0x589F, 0xC108, 0xF239, 0xA76A, 0x945B,
+		0x8465, 0xB754, 0xE207, 0xD136, 0x48A1, 0x7B90, 0x2EC3, 0x1DF2,
+		0x0EBF, 0x3D8E, 0x68DD, 0x5BEC, 0xC27B, 0xF14A, 0xA419, 0x9728,
+		0x8716, 0xB427, 0xE174, 0xD245, 0x4BD2, 0x78E3, 0x2DB0, 0x1E81,
+		0x0B2A, 0x381B, 0x6D48, 0x5E79, 0xC7EE, 0xF4DF, 0xA18C, 0x92BD,
+		0x8283, 0xB1B2, 0xE4E1, 0xD7D0, 0x4E47, 0x7D76, 0x2825, 0x1B14,
+		0x0859, 0x3B68, 0x6E3B, 0x5D0A, 0xC49D, 0xF7AC, 0xA2FF, 0x91CE,
+		0x81F0, 0xB2C1, 0xE792, 0xD4A3, 0x4D34, 0x7E05, 0x2B56, 0x1867,
+		0x1B98, 0x28A9, 0x7DFA, 0x4ECB, 0xD75C, 0xE46D, 0xB13E, 0x820F,
+		0x9231, 0xA100, 0xF453, 0xC762, 0x5EF5, 0x6DC4, 0x3897, 0x0BA6,
+		0x18EB, 0x2BDA, 0x7E89, 0x4DB8, 0xD42F, 0xE71E, 0xB24D, 0x817C,
+		0x9142, 0xA273, 0xF720, 0xC411, 0x5D86, 0x6EB7, 0x3BE4, 0x08D5,
+		0x1D7E, 0x2E4F, 0x7B1C, 0x482D, 0xD1BA, 0xE28B, 0xB7D8, 0x84E9,
+		0x94D7, 0xA7E6, 0xF2B5, 0xC184, 0x5813, 0x6B22, 0x3E71, 0x0D40,
+		0x1E0D, 0x2D3C, 0x786F, 0x4B5E, 0xD2C9, 0xE1F8, 0xB4AB, 0x879A,
+		0x97A4, 0xA495, 0xF1C6, 0xC2F7, 0x5B60, 0x6851, 0x3D02, 0x0E33,
+		0x1654, 0x2565, 0x7036, 0x4307, 0xDA90, 0xE9A1, 0xBCF2, 0x8FC3,
+		0x9FFD, 0xACCC, 0xF99F, 0xCAAE, 0x5339, 0x6008, 0x355B, 0x066A,
+		0x1527, 0x2616, 0x7345, 0x4074, 0xD9E3, 0xEAD2, 0xBF81, 0x8CB0,
+		0x9C8E, 0xAFBF, 0xFAEC, 0xC9DD, 0x504A, 0x637B, 0x3628, 0x0519,
+		0x10B2, 0x2383, 0x76D0, 0x45E1, 0xDC76, 0xEF47, 0xBA14, 0x8925,
+		0x991B, 0xAA2A, 0xFF79, 0xCC48, 0x55DF, 0x66EE, 0x33BD, 0x008C,
+		0x13C1, 0x20F0, 0x75A3, 0x4692, 0xDF05, 0xEC34, 0xB967, 0x8A56,
+		0x9A68, 0xA959, 0xFC0A, 0xCF3B, 0x56AC, 0x659D, 0x30CE, 0x03FF,
+	},
+	{	/* 2 */
+		0x0000, 0x3730, 0x6E60, 0x5950, 0xDCC0, 0xEBF0, 0xB2A0, 0x8590,
+		0xA9A1, 0x9E91, 0xC7C1, 0xF0F1, 0x7561, 0x4251, 0x1B01, 0x2C31,
+		0x4363, 0x7453, 0x2D03, 0x1A33, 0x9FA3, 0xA893, 0xF1C3, 0xC6F3,
+		0xEAC2, 0xDDF2, 0x84A2, 0xB392, 0x3602, 0x0132, 0x5862, 0x6F52,
+		0x86C6, 0xB1F6, 0xE8A6, 0xDF96, 0x5A06, 0x6D36, 0x3466, 0x0356,
+		0x2F67, 0x1857, 0x4107, 0x7637, 0xF3A7, 0xC497, 0x9DC7, 0xAAF7,
+		0xC5A5, 0xF295, 0xABC5, 0x9CF5, 0x1965, 0x2E55, 0x7705, 0x4035,
+		0x6C04, 0x5B34, 0x0264, 0x3554, 0xB0C4, 0x87F4, 0xDEA4, 0xE994,
+		0x1DAD, 0x2A9D, 0x73CD, 0x44FD, 0xC16D, 0xF65D, 0xAF0D, 0x983D,
+		0xB40C, 0x833C, 0xDA6C, 0xED5C, 0x68CC, 0x5FFC, 0x06AC, 0x319C,
+		0x5ECE, 0x69FE, 0x30AE, 0x079E, 0x820E, 0xB53E, 0xEC6E, 0xDB5E,
+		0xF76F, 0xC05F, 0x990F, 0xAE3F, 0x2BAF, 0x1C9F, 0x45CF, 0x72FF,
+		0x9B6B, 0xAC5B, 0xF50B, 0xC23B, 0x47AB, 0x709B, 0x29CB, 0x1EFB,
+		0x32CA, 0x05FA, 0x5CAA, 0x6B9A, 0xEE0A, 0xD93A, 0x806A, 0xB75A,
+		0xD808, 0xEF38, 0xB668, 0x8158, 0x04C8, 0x33F8, 0x6AA8, 0x5D98,
+		0x71A9, 0x4699, 0x1FC9, 0x28F9, 0xAD69, 0x9A59, 0xC309, 0xF439,
+		0x3B5A, 0x0C6A, 0x553A, 0x620A, 0xE79A, 0xD0AA, 0x89FA, 0xBECA,
+		0x92FB, 0xA5CB, 0xFC9B, 0xCBAB, 0x4E3B, 0x790B, 0x205B, 0x176B,
+		0x7839, 0x4F09, 0x1659, 0x2169, 0xA4F9, 0x93C9, 0xCA99, 0xFDA9,
+		0xD198, 0xE6A8, 0xBFF8, 0x88C8, 0x0D58, 0x3A68, 0x6338, 0x5408,
+		0xBD9C, 0x8AAC, 0xD3FC, 0xE4CC, 0x615C, 0x566C, 0x0F3C, 0x380C,
+		0x143D, 0x230D, 0x7A5D, 0x4D6D, 0xC8FD, 0xFFCD, 0xA69D, 0x91AD,
+		0xFEFF, 0xC9CF, 0x909F, 0xA7AF, 0x223F, 0x150F, 0x4C5F, 0x7B6F,
+		0x575E, 0x606E, 0x393E, 0x0E0E, 0x8B9E, 0xBCAE, 0xE5FE, 0xD2CE,
+		0x26F7, 0x11C7, 0x4897, 0x7FA7, 0xFA37, 0xCD07, 0x9457, 0xA367,
+		0x8F56, 0xB866, 0xE136, 0xD606, 0x5396, 0x64A6, 0x3DF6, 0x0AC6,
+		0x6594, 0x52A4, 0x0BF4, 0x3CC4, 0xB954, 0x8E64, 0xD734, 0xE004,
+		0xCC35, 0xFB05, 0xA255, 0x9565, 0x10F5, 0x27C5, 0x7E95, 0x49A5,
+		0xA031, 0x9701, 0xCE51, 0xF961, 0x7CF1, 0x4BC1, 0x1291, 0x25A1,
+		0x0990, 0x3EA0, 0x67F0, 0x50C0, 0xD550, 0xE260, 0xBB30, 0x8C00,
+		0xE352, 0xD462, 0x8D32, 0xBA02, 0x3F92, 0x08A2, 0x51F2, 0x66C2,
+		0x4AF3, 0x7DC3, 0x2493, 0x13A3, 0x9633, 0xA103, 0xF853, 0xCF63,
+	},
+	{	/* 3 */
+		0x0000, 0x76B4, 0xED68, 0x9BDC, 0xCAF1, 0xBC45, 0x2799, 0x512D,
+		0x85C3, 0xF377, 0x68AB, 0x1E1F, 0x4F32, 0x3986, 0xA25A, 0xD4EE,
+		0x1BA7, 0x6D13, 0xF6CF, 0x807B, 0xD156, 0xA7E2, 0x3C3E, 0x4A8A,
+		0x9E64, 0xE8D0, 0x730C, 0x05B8, 0x5495, 0x2221, 0xB9FD, 0xCF49,
+		0x374E, 0x41FA, 0xDA26, 0xAC92, 0xFDBF, 0x8B0B, 0x10D7, 0x6663,
+		0xB28D, 0xC439, 0x5FE5, 0x2951, 0x787C, 0x0EC8, 0x9514, 0xE3A0,
+		0x2CE9, 0x5A5D, 0xC181, 0xB735, 0xE618, 0x90AC, 0x0B70, 0x7DC4,
+		0xA92A, 0xDF9E, 0x4442, 0x32F6, 0x63DB, 0x156F, 0x8EB3, 0xF807,
+		0x6E9C, 0x1828, 0x83F4, 0xF540, 0xA46D, 0xD2D9, 0x4905, 0x3FB1,
+		0xEB5F, 0x9DEB, 0x0637, 0x7083, 0x21AE, 0x571A, 0xCCC6, 0xBA72,
+		0x753B, 0x038F, 0x9853, 0xEEE7, 0xBFCA, 0xC97E, 0x52A2, 0x2416,
+		0xF0F8, 0x864C, 0x1D90, 0x6B24, 0x3A09, 0x4CBD, 0xD761, 0xA1D5,
+		0x59D2, 0x2F66, 0xB4BA, 0xC20E, 0x9323, 0xE597, 0x7E4B, 0x08FF,
+		0xDC11, 0xAAA5, 0x3179, 0x47CD, 0x16E0, 0x6054, 0xFB88, 0x8D3C,
+		0x4275, 0x34C1, 0xAF1D, 0xD9A9, 0x8884, 0xFE30, 0x65EC, 0x1358,
+		0xC7B6, 0xB102, 0x2ADE, 0x5C6A, 0x0D47, 0x7BF3, 0xE02F, 0x969B,
+		0xDD38, 0xAB8C, 0x3050, 0x46E4, 0x17C9, 0x617D, 0xFAA1, 0x8C15,
+		0x58FB, 0x2E4F, 0xB593, 0xC327, 0x920A, 0xE4BE, 0x7F62, 0x09D6,
+		0xC69F, 0xB02B, 0x2BF7, 0x5D43, 0x0C6E, 0x7ADA, 0xE106, 0x97B2,
+		0x435C, 0x35E8, 0xAE34, 0xD880, 0x89AD, 0xFF19, 0x64C5, 0x1271,
+		0xEA76, 0x9CC2, 0x071E, 0x71AA, 0x2087, 0x5633, 0xCDEF, 0xBB5B,
+		0x6FB5, 0x1901, 0x82DD, 0xF469, 0xA544, 0xD3F0, 0x482C, 0x3E98,
+		0xF1D1, 0x8765, 0x1CB9, 0x6A0D, 0x3B20, 0x4D94, 0xD648, 0xA0FC,
+		0x7412, 0x02A6, 0x997A, 0xEFCE, 0xBEE3, 0xC857, 0x538B, 0x253F,
+		0xB3A4, 0xC510, 0x5ECC, 0x2878, 0x7955, 0x0FE1, 0x943D, 0xE289,
+		0x3667, 0x40D3, 0xDB0F, 0xADBB, 0xFC96, 0x8A22, 0x11FE, 0x674A,
+		0xA803, 0xDEB7, 0x456B, 0x33DF, 0x62F2, 0x1446, 0x8F9A, 0xF92E,
+		0x2DC0, 0x5B74, 0xC0A8, 0xB61C, 0xE731, 0x9185, 0x0A59, 0x7CED,
+		0x84EA, 0xF25E, 0x6982, 0x1F36, 0x4E1B, 0x38AF, 0xA373, 0xD5C7,
+		0x0129, 0x779D, 0xEC41, 0x9AF5, 0xCBD8, 0xBD6C, 0x26B0, 0x5004,
+		0x9F4D, 0xE9F9, 0x7225, 0x0491, 0x55BC, 0x2308, 0xB8D4, 0xCE60,
+		0x1A8E, 0x6C3A, 0xF7E6, 0x8152, 0xD07F, 0xA6CB, 0x3D17, 0x4BA3,
+	},
+	{	/* 4 */
+		0x0000, 0xAA51, 0x4483, 0xEED2, 0x8906, 0x2357, 0xCD85, 0x67D4,
+		0x022D, 0xA87C, 0x46AE, 0xECFF, 0x8B2B, 0x217A, 0xCFA8, 0x65F9,
+		0x045A, 0xAE0B, 0x40D9, 0xEA88, 0x8D5C, 0x270D, 0xC9DF, 0x638E,
+		0x0677, 0xAC26, 0x42F4, 0xE8A5, 0x8F71, 0x2520, 0xCBF2, 0x61A3,
+		0x08B4, 0xA2E5, 0x4C37, 0xE666, 0x81B2, 0x2BE3, 0xC531, 0x6F60,
+		0x0A99, 0xA0C8, 0x4E1A, 0xE44B, 0x839F, 0x29CE, 0xC71C, 0x6D4D,
+		0x0CEE, 0xA6BF, 0x486D, 0xE23C, 0x85E8, 0x2FB9, 0xC16B, 0x6B3A,
+		0x0EC3, 0xA492, 0x4A40, 0xE011, 0x87C5, 0x2D94, 0xC346, 0x6917,
+		0x1168, 0xBB39, 0x55EB, 0xFFBA, 0x986E, 0x323F, 0xDCED, 0x76BC,
+		0x1345, 0xB914, 0x57C6, 0xFD97, 0x9A43, 0x3012, 0xDEC0, 0x7491,
+		0x1532, 0xBF63, 0x51B1, 0xFBE0, 0x9C34, 0x3665, 0xD8B7, 0x72E6,
+		0x171F, 0xBD4E, 0x539C, 0xF9CD, 0x9E19, 0x3448, 0xDA9A, 0x70CB,
+		0x19DC, 0xB38D, 0x5D5F, 0xF70E, 0x90DA, 0x3A8B, 0xD459, 0x7E08,
+		0x1BF1, 0xB1A0, 0x5F72, 0xF523, 0x92F7, 0x38A6, 0xD674, 0x7C25,
+		0x1D86, 0xB7D7, 0x5905, 0xF354, 0x9480, 0x3ED1, 0xD003, 0x7A52,
+		0x1FAB, 0xB5FA, 0x5B28, 0xF179, 0x96AD, 0x3CFC, 0xD22E, 0x787F,
+		0x22D0, 0x8881, 0x6653, 0xCC02, 0xABD6, 0x0187, 0xEF55, 0x4504,
+		0x20FD, 0x8AAC, 0x647E, 0xCE2F, 0xA9FB, 0x03AA, 0xED78, 0x4729,
+		0x268A, 0x8CDB, 0x6209, 0xC858, 0xAF8C, 0x05DD, 0xEB0F, 0x415E,
+		0x24A7, 0x8EF6, 0x6024, 0xCA75, 0xADA1, 0x07F0, 0xE922, 0x4373,
+		0x2A64, 0x8035, 0x6EE7, 0xC4B6, 0xA362, 0x0933, 0xE7E1, 0x4DB0,
+		0x2849, 0x8218, 0x6CCA, 0xC69B, 0xA14F, 0x0B1E, 0xE5CC, 0x4F9D,
+		0x2E3E, 0x846F, 0x6ABD, 0xC0EC, 0xA738, 0x0D69, 0xE3BB, 0x49EA,
+		0x2C13, 0x8642, 0x6890, 0xC2C1, 0xA515, 0x0F44, 0xE196, 0x4BC7,
+		0x33B8, 0x99E9, 0x773B, 0xDD6A, 0xBABE, 0x10EF, 0xFE3D, 0x546C,
+		0x3195, 0x9BC4, 0x7516, 0xDF47, 0xB893, 0x12C2, 0xFC10, 0x5641,
+		0x37E2, 0x9DB3, 0x7361, 0xD930, 0xBEE4, 0x14B5, 0xFA67, 0x5036,
+		0x35CF, 0x9F9E, 0x714C, 0xDB1D, 0xBCC9, 0x1698, 0xF84A, 0x521B,
+		0x3B0C, 0x915D, 0x7F8F, 0xD5DE, 0xB20A, 0x185B, 0xF689, 0x5CD8,
+		0x3921, 0x9370, 0x7DA2, 0xD7F3, 0xB027, 0x1A76, 0xF4A4, 0x5EF5,
+		0x3F56, 0x9507, 0x7BD5, 0xD184, 0xB650, 0x1C01, 0xF2D3, 0x5882,
+		0x3D7B, 0x972A, 0x79F8, 0xD3A9, 0xB47D, 0x1E2C, 0xF0FE, 0x5AAF,
+	},
+	{	/* 5 */
+		0x0000, 0x45A0, 0x8B40, 0xCEE0, 0x06A1, 0x4301, 0x8DE1, 0xC841,
+		0x0D42, 0x48E2, 0x8602, 0xC3A2, 0x0BE3, 0x4E43, 0x80A3, 0xC503,
+		0x1A84, 0x5F24, 0x91C4, 0xD464, 0x1C25, 0x5985, 0x9765, 0xD2C5,
+		0x17C6, 0x5266, 0x9C86, 0xD926, 0x1167, 0x54C7, 0x9A27, 0xDF87,
+		0x3508, 0x70A8, 0xBE48, 0xFBE8, 0x33A9, 0x7609, 0xB8E9, 0xFD49,
+		0x384A, 0x7DEA, 0xB30A, 0xF6AA, 0x3EEB, 0x7B4B, 0xB5AB, 0xF00B,
+		0x2F8C, 0x6A2C, 0xA4CC, 0xE16C, 0x292D, 0x6C8D, 0xA26D, 0xE7CD,
+		0x22CE, 0x676E, 0xA98E, 0xEC2E, 0x246F, 0x61CF, 0xAF2F, 0xEA8F,
+		0x6A10, 0x2FB0, 0xE150, 0xA4F0, 0x6CB1, 0x2911, 0xE7F1, 0xA251,
+		0x6752, 0x22F2, 0xEC12, 0xA9B2, 0x61F3, 0x2453, 0xEAB3, 0xAF13,
+		0x7094, 0x3534, 0xFBD4, 0xBE74, 0x7635, 0x3395, 0xFD75, 0xB8D5,
+		0x7DD6, 0x3876, 0xF696, 0xB336, 0x7B77, 0x3ED7, 0xF037, 0xB597,
+		0x5F18, 0x1AB8, 0xD458, 0x91F8, 0x59B9, 0x1C19, 0xD2F9, 0x9759,
+		0x525A, 0x17FA, 0xD91A, 0x9CBA, 0x54FB, 0x115B, 0xDFBB, 0x9A1B,
+		0x459C, 0x003C, 0xCEDC, 0x8B7C, 0x433D, 0x069D, 0xC87D, 0x8DDD,
+		0x48DE, 0x0D7E, 0xC39E, 0x863E, 0x4E7F, 0x0BDF, 0xC53F, 0x809F,
+		0xD420, 0x9180, 0x5F60, 0x1AC0, 0xD281, 0x9721, 0x59C1, 0x1C61,
+		0xD962, 0x9CC2, 0x5222, 0x1782, 0xDFC3, 0x9A63, 0x5483, 0x1123,
+		0xCEA4, 0x8B04, 0x45E4, 0x0044, 0xC805, 0x8DA5, 0x4345, 0x06E5,
+		0xC3E6, 0x8646, 0x48A6, 0x0D06, 0xC547, 0x80E7, 0x4E07, 0x0BA7,
+		0xE128, 0xA488, 0x6A68, 0x2FC8, 0xE789, 0xA229, 0x6CC9, 0x2969,
+		0xEC6A, 0xA9CA, 0x672A, 0x228A, 0xEACB, 0xAF6B, 0x618B, 0x242B,
+		0xFBAC, 0xBE0C, 0x70EC, 0x354C, 0xFD0D, 0xB8AD, 0x764D, 0x33ED,
+		0xF6EE, 0xB34E, 0x7DAE, 0x380E, 0xF04F, 0xB5EF, 0x7B0F, 0x3EAF,
+		0xBE30, 0xFB90, 0x3570, 0x70D0, 0xB891, 0xFD31, 0x33D1, 0x7671,
+		0xB372, 0xF6D2, 0x3832, 0x7D92, 0xB5D3, 0xF073, 0x3E93, 0x7B33,
+		0xA4B4, 0xE114, 0x2FF4, 0x6A54, 0xA215, 0xE7B5, 0x2955, 0x6CF5,
+		0xA9F6, 0xEC56, 0x22B6, 0x6716, 0xAF57, 0xEAF7, 0x2417, 0x61B7,
+		0x8B38, 0xCE98, 0x0078, 0x45D8, 0x8D99, 0xC839, 0x06D9, 0x4379,
+		0x867A, 0xC3DA, 0x0D3A, 0x489A, 0x80DB, 0xC57B, 0x0B9B, 0x4E3B,
+		0x91BC, 0xD41C, 0x1AFC, 0x5F5C, 0x971D, 0xD2BD, 0x1C5D, 0x59FD,
+		0x9CFE, 0xD95E, 0x17BE, 0x521E, 0x9A5F, 0xDFFF, 0x111F, 0x54BF,
+	},
+	{	/* 6 */
+		0x0000, 0xB861, 0x60E3, 0xD882, 0xC1C6, 0x79A7, 0xA125, 0x1944,
+		0x93AD, 0x2BCC, 0xF34E, 0x4B2F, 0x526B, 0xEA0A, 0x3288, 0x8AE9,
+		0x377B, 0x8F1A, 0x5798, 0xEFF9, 0xF6BD, 0x4EDC, 0x965E, 0x2E3F,
+		0xA4D6, 0x1CB7, 0xC435, 0x7C54, 0x6510, 0xDD71, 0x05F3, 0xBD92,
+		0x6EF6, 0xD697, 0x0E15, 0xB674, 0xAF30, 0x1751, 0xCFD3, 0x77B2,
+		0xFD5B, 0x453A, 0x9DB8, 0x25D9, 0x3C9D, 0x84FC, 0x5C7E, 0xE41F,
+		0x598D, 0xE1EC, 0x396E, 0x810F, 0x984B, 0x202A, 0xF8A8, 0x40C9,
+		0xCA20, 0x7241, 0xAAC3, 0x12A2, 0x0BE6, 0xB387, 0x6B05, 0xD364,
+		0xDDEC, 0x658D, 0xBD0F, 0x056E, 0x1C2A, 0xA44B, 0x7CC9, 0xC4A8,
+		0x4E41, 0xF620, 0x2EA2, 0x96C3, 0x8F87, 0x37E6, 0xEF64, 0x5705,
+		0xEA97, 0x52F6, 0x8A74, 0x3215, 0x2B51, 0x9330, 0x4BB2, 0xF3D3,
+		0x793A, 0xC15B, 0x19D9, 0xA1B8, 0xB8FC, 0x009D, 0xD81F, 0x607E,
+		0xB31A, 0x0B7B, 0xD3F9, 0x6B98, 0x72DC, 0xCABD, 0x123F, 0xAA5E,
+		0x20B7, 0x98D6, 0x4054, 0xF835, 0xE171, 0x5910, 0x8192, 0x39F3,
+		0x8461, 0x3C00, 0xE482, 0x5CE3, 0x45A7, 0xFDC6, 0x2544, 0x9D25,
+		0x17CC, 0xAFAD, 0x772F, 0xCF4E, 0xD60A, 0x6E6B, 0xB6E9, 0x0E88,
+		0xABF9, 0x1398, 0xCB1A, 0x737B, 0x6A3F, 0xD25E, 0x0ADC, 0xB2BD,
+		0x3854, 0x8035, 0x58B7, 0xE0D6, 0xF992, 0x41F3, 0x9971, 0x2110,
+		0x9C82, 0x24E3, 0xFC61, 0x4400, 0x5D44, 0xE525, 0x3DA7, 0x85C6,
+		0x0F2F, 0xB74E, 0x6FCC, 0xD7AD, 0xCEE9, 0x7688, 0xAE0A, 0x166B,
+		0xC50F, 0x7D6E, 0xA5EC, 0x1D8D, 0x04C9, 0xBCA8, 0x642A, 0xDC4B,
+		0x56A2, 0xEEC3, 0x3641, 0x8E20, 0x9764, 0x2F05, 0xF787, 0x4FE6,
+		0xF274, 0x4A15, 0x9297, 0x2AF6, 0x33B2, 0x8BD3, 0x5351, 0xEB30,
+		0x61D9, 0xD9B8, 0x013A, 0xB95B, 0xA01F, 0x187E, 0xC0FC, 0x789D,
+		0x7615, 0xCE74, 0x16F6, 0xAE97, 0xB7D3, 0x0FB2, 0xD730, 0x6F51,
+		0xE5B8, 0x5DD9, 0x855B, 0x3D3A, 0x247E, 0x9C1F, 0x449D, 0xFCFC,
+		0x416E, 0xF90F, 0x218D, 0x99EC, 0x80A8, 0x38C9, 0xE04B, 0x582A,
+		0xD2C3, 0x6AA2, 0xB220, 0x0A41, 0x1305, 0xAB64, 0x73E6, 0xCB87,
+		0x18E3, 0xA082, 0x7800, 0xC061, 0xD925, 0x6144, 0xB9C6, 0x01A7,
+		0x8B4E, 0x332F, 0xEBAD, 0x53CC, 0x4A88, 0xF2E9, 0x2A6B, 0x920A,
+		0x2F98, 0x97F9, 0x4F7B, 0xF71A, 0xEE5E, 0x563F, 0x8EBD, 0x36DC,
+		0xBC35, 0x0454, 0xDCD6, 0x64B7, 0x7DF3, 0xC592, 0x1D10, 0xA571,
+	},
+	{	/* 7 */
+		0x0000, 0x47D3, 0x8FA6, 0xC875, 0x0F6D, 0x48BE, 0x80CB, 0xC718,
+		0x1EDA, 0x5909, 0x917C, 0xD6AF, 0x11B7, 0x5664, 0x9E11, 0xD9C2,
+		0x3DB4, 0x7A67, 0xB212, 0xF5C1, 0x32D9, 0x750A, 0xBD7F, 0xFAAC,
+		0x236E, 0x64BD, 0xACC8, 0xEB1B, 0x2C03, 0x6BD0, 0xA3A5, 0xE476,
+		0x7B68, 0x3CBB, 0xF4CE, 0xB31D, 0x7405, 0x33D6, 0xFBA3, 0xBC70,
+		0x65B2, 0x2261, 0xEA14, 0xADC7, 0x6ADF, 0x2D0C, 0xE579, 0xA2AA,
+		0x46DC, 0x010F, 0xC97A, 0x8EA9, 0x49B1, 0x0E62, 0xC617, 0x81C4,
+		0x5806, 0x1FD5, 0xD7A0, 0x9073, 0x576B, 0x10B8, 0xD8CD, 0x9F1E,
+		0xF6D0, 0xB103, 0x7976, 0x3EA5, 0xF9BD, 0xBE6E, 0x761B, 0x31C8,
+		0xE80A, 0xAFD9, 0x67AC, 0x207F, 0xE767, 0xA0B4, 0x68C1, 0x2F12,
+		0xCB64, 0x8CB7, 0x44C2, 0x0311, 0xC409, 0x83DA, 0x4BAF, 0x0C7C,
+		0xD5BE, 0x926D, 0x5A18, 0x1DCB, 0xDAD3, 0x9D00, 0x5575, 0x12A6,
+		0x8DB8, 0xCA6B, 0x021E, 0x45CD, 0x82D5, 0xC506, 0x0D73, 0x4AA0,
+		0x9362, 0xD4B1, 0x1CC4, 0x5B17, 0x9C0F, 0xDBDC, 0x13A9, 0x547A,
+		0xB00C, 0xF7DF, 0x3FAA, 0x7879, 0xBF61, 0xF8B2, 0x30C7, 0x7714,
+		0xAED6, 0xE905, 0x2170, 0x66A3, 0xA1BB, 0xE668, 0x2E1D, 0x69CE,
+		0xFD81, 0xBA52, 0x7227, 0x35F4, 0xF2EC, 0xB53F, 0x7D4A, 0x3A99,
+		0xE35B, 0xA488, 0x6CFD, 0x2B2E, 0xEC36, 0xABE5, 0x6390, 0x2443,
+		0xC035, 0x87E6, 0x4F93, 0x0840, 0xCF58, 0x888B, 0x40FE, 0x072D,
+		0xDEEF, 0x993C, 0x5149, 0x169A, 0xD182, 0x9651, 0x5E24, 0x19F7,
+		0x86E9, 0xC13A, 0x094F, 0x4E9C, 0x8984, 0xCE57, 0x0622, 0x41F1,
+		0x9833, 0xDFE0, 0x1795, 0x5046, 0x975E, 0xD08D, 0x18F8, 0x5F2B,
+		0xBB5D, 0xFC8E, 0x34FB, 0x7328, 0xB430, 0xF3E3, 0x3B96, 0x7C45,
+		0xA587, 0xE254, 0x2A21, 0x6DF2, 0xAAEA, 0xED39, 0x254C, 0x629F,
+		0x0B51, 0x4C82, 0x84F7, 0xC324, 0x043C, 0x43EF, 0x8B9A, 0xCC49,
+		0x158B, 0x5258, 0x9A2D, 0xDDFE, 0x1AE6, 0x5D35, 0x9540, 0xD293,
+		0x36E5, 0x7136, 0xB943, 0xFE90, 0x3988, 0x7E5B, 0xB62E, 0xF1FD,
+		0x283F, 0x6FEC, 0xA799, 0xE04A, 0x2752, 0x6081, 0xA8F4, 0xEF27,
+		0x7039, 0x37EA, 0xFF9F, 0xB84C, 0x7F54, 0x3887, 0xF0F2, 0xB721,
+		0x6EE3, 0x2930, 0xE145, 0xA696, 0x618E, 0x265D, 0xEE28, 0xA9FB,
+		0x4D8D, 0x0A5E, 0xC22B, 0x85F8, 0x42E0, 0x0533, 0xCD46, 0x8A95,
+		0x5357, 0x1484, 0xDCF1, 0x9B22, 0x5C3A, 0x1BE9, 0xD39C, 0x944F,
+	},
+#if (YM_CRC_SLICE == 16)
+	{	/* 8 */
+		0x0000, 0xEB23, 0xC667, 0x2D44, 0x9CEF, 0x77CC, 0x5A88, 0xB1AB,
+		0x29FF, 0xC2DC, 0xEF98, 0x04BB, 0xB510, 0x5E33, 0x7377, 0x9854,
+		0x53FE, 0xB8DD, 0x9599, 0x7EBA, 0xCF11, 0x2432, 0x0976, 0xE255,
+		0x7A01, 0x9122, 0xBC66, 0x5745, 0xE6EE, 0x0DCD, 0x2089, 0xCBAA,
+		0xA7FC, 0x4CDF, 0x619B, 0x8AB8, 0x3B13, 0xD030, 0xFD74, 0x1657,
+		0x8E03, 0x6520, 0x4864, 0xA347, 0x12EC, 0xF9CF, 0xD48B, 0x3FA8,
+		0xF402, 0x1F21, 0x3265, 0xD946, 0x68ED, 0x83CE, 0xAE8A, 0x45A9,
+		0xDDFD, 0x36DE, 0x1B9A, 0xF0B9, 0x4112, 0xAA31, 0x8775, 0x6C56,
+		0x5FD9, 0xB4FA, 0x99BE, 0x729D, 0xC336, 0x2815, 0x0551, 0xEE72,
+		0x7626, 0x9D05, 0xB041, 0x5B62, 0xEAC9, 0x01EA, 0x2CAE, 0xC78D,
+		0x0C27, 0xE704, 0xCA40, 0x2163, 0x90C8, 0x7BEB, 0x56AF, 0xBD8C,
+		0x25D8, 0xCEFB, 0xE3BF, 0x089C, 0xB937, 0x5214, 0x7F50, 0x9473,
+		0xF825, 0x1306, 0x3E42, 0xD561, 0x64CA, 0x8FE9, 0xA2AD, 0x498E,
+		0xD1DA, 0x3AF9, 0x17BD, 0xFC9E, 0x4D35, 0xA616, 0x8B52, 0x6071,
+		0xABDB, 0x40F8, 0x6DBC, 0x869F, 0x3734, 0xDC17, 0xF153, 0x1A70,
+		0x8224, 0x6907, 0x4443, 0xAF60, 0x1ECB, 0xF5E8, 0xD8AC, 0x338F,
+		0xBFB2, 0x5491, 0x79D5, 0x92F6, 0x235D, 0xC87E, 0xE53A, 0x0E19,
+		0x964D, 0x7D6E, 0x502A, 0xBB09, 0x0AA2, 0xE181, 0xCCC5, 0x27E6,
+		0xEC4C, 0x076F, 0x2A2B, 0xC108, 0x70A3, 0x9B80, 0xB6C4, 0x5DE7,
+		0xC5B3, 0x2E90, 0x03D4, 0xE8F7, 0x595C, 0xB27F, 0x9F3B, 0x7418,
+		0x184E, 0xF36D, 0xDE29, 0x350A, 0x84A1, 0x6F82, 0x42C6, 0xA9E5,
+		0x31B1, 0xDA92, 0xF7D6, 0x1CF5, 0xAD5E, 0x467D, 0x6B39, 0x801A,
+		0x4BB0, 0xA093, 0x8DD7, 0x66F4, 0xD75F, 0x3C7C, 0x1138, 0xFA1B,
+		0x624F, 0x896C, 0xA428, 0x4F0B, 0xFEA0, 0x1583, 0x38C7, 0xD3E4,
+		0xE06B, 0x0B48, 0x260C, 0xCD2F, 0x7C84, 0x97A7, 0xBAE3, 0x51C0,
+		0xC994, 0x22B7, 0x0FF3, 0xE4D0, 0x557B, 0xBE58, 0x931C, 0x783F,
+		0xB395, 0x58B6, 0x75F2, 0x9ED1, 0x2F7A, 0xC459, 0xE91D, 0x023E,
+		0x9A6A, 0x7149, 0x5C0D, 0xB72E, 0x0685, 0xEDA6, 0xC0E2, 0x2BC1,
+		0x4797, 0xACB4, 0x81F0, 0x6AD3, 0xDB78, 0x305B, 0x1D1F, 0xF63C,
+		0x6E68, 0x854B, 0xA80F, 0x432C, 0xF287, 0x19A4, 0x34E0, 0xDFC3,
+		0x1469, 0xFF4A, 0xD20E, 0x392D, 0x8886, 0x63A5, 0x4EE1, 0xA5C2,
+		0x3D96, 0xD6B5, 0xFBF1, 0x10D2, 0xA179, 0x4A5A, 0x671E, 0x8C3D,
+	},
+	{	/* 9 */
+		0x0000, 0x6F45, 0xDE8A, 0xB1CF, 0xAD35, 0xC270, 0x73BF, 0x1CFA,
+		0x4A4B, 0x250E, 0x94C1, 0xFB84, 0xE77E, 0x883B, 0x39F4, 0x56B1,
+		0x9496, 0xFBD3, 0x4A1C, 0x2559, 0x39A3, 0x56E6, 0xE729, 0x886C,
+		0xDEDD, 0xB198, 0x0057, 0x6F12, 0x73E8, 0x1CAD, 0xAD62, 0xC227,
+		0x390D, 0x5648, 0xE787, 0x88C2, 0x9438, 0xFB7D, 0x4AB2, 0x25F7,
+		0x7346, 0x1C03, 0xADCC, 0xC289, 0xDE73, 0xB136, 0x00F9, 0x6FBC,
+		0xAD9B, 0xC2DE, 0x7311, 0x1C54, 0x00AE, 0x6FEB, 0xDE24, 0xB161,
+		0xE7D0, 0x8895, 0x395A, 0x561F, 0x4AE5, 0x25A0, 0x946F, 0xFB2A,
+		0x721A, 0x1D5F, 0xAC90, 0xC3D5, 0xDF2F, 0xB06A, 0x01A5, 0x6EE0,
+		0x3851, 0x5714, 0xE6DB, 0x899E, 0x9564, 0xFA21, 0x4BEE, 0x24AB,
+		0xE68C, 0x89C9, 0x3806, 0x5743, 0x4BB9, 0x24FC, 0x9533, 0xFA76,
+		0xACC7, 0xC382, 0x724D, 0x1D08, 0x01F2, 0x6EB7, 0xDF78, 0xB03D,
+		0x4B17, 0x2452, 0x959D, 0xFAD8, 0xE622, 0x8967, 0x38A8, 0x57ED,
+		0x015C, 0x6E19, 0xDFD6, 0xB093, 0xAC69, 0xC32C, 0x72E3, 0x1DA6,
+		0xDF81, 0xB0C4, 0x010B, 0x6E4E, 0x72B4, 0x1DF1, 0xAC3E, 0xC37B,
+		0x95CA, 0xFA8F, 0x4B40, 0x2405, 0x38FF, 0x57BA, 0xE675, 0x8930,
+		0xE434, 0x8B71, 0x3ABE, 0x55FB, 0x4901, 0x2644, 0x978B, 0xF8CE,
+		0xAE7F, 0xC13A, 0x70F5, 0x1FB0, 0x034A, 0x6C0F, 0xDDC0, 0xB285,
+		0x70A2, 0x1FE7, 0xAE28, 0xC16D, 0xDD97, 0xB2D2, 0x031D, 0x6C58,
+		0x3AE9, 0x55AC, 0xE463, 0x8B26, 0x97DC, 0xF899, 0x4956, 0x2613,
+		0xDD39, 0xB27C, 0x03B3, 0x6CF6, 0x700C, 0x1F49, 0xAE86, 0xC1C3,
+		0x9772, 0xF837, 0x49F8, 0x26BD, 0x3A47, 0x5502, 0xE4CD, 0x8B88,
+		0x49AF, 0x26EA, 0x9725, 0xF860, 0xE49A, 0x8BDF, 0x3A10, 0x5555,
+		0x03E4, 0x6CA1, 0xDD6E, 0xB22B, 0xAED1, 0xC194, 0x705B, 0x1F1E,
+		0x962E, 0xF96B, 0x48A4, 0x27E1, 0x3B1B, 0x545E, 0xE591, 0x8AD4,
+		0xDC65, 0xB320, 0x02EF, 0x6DAA, 0x7150, 0x1E15, 0xAFDA, 0xC09F,
+		0x02B8, 0x6DFD, 0xDC32, 0xB377, 0xAF8D, 0xC0C8, 0x7107, 0x1E42,
+		0x48F3, 0x27B6, 0x9679, 0xF93C, 0xE5C6, 0x8A83, 0x3B4C, 0x5409,
+		0xAF23, 0xC066, 0x71A9, 0x1EEC, 0x0216, 0x6D53, 0xDC9C, 0xB3D9,
+		0xE568, 0x8A2D, 0x3BE2, 0x54A7, 0x485D, 0x2718, 0x96D7, 0xF992,
+		0x3BB5, 0x54F0, 0xE53F, 0x8A7A, 0x9680, 0xF9C5, 0x480A, 0x274F,
+		0x71FE, 0x1EBB, 0xAF74, 0xC031, 0xDCCB, 0xB38E, 0x0241, 0x6D04,
+	},
+	{	/* 10 */
+		0x0000, 0xD849, 0xA0B3, 0x78FA, 0x5147, 0x890E, 0xF1F4, 0x29BD,
+		0xA28E, 0x7AC7, 0x023D, 0xDA74, 0xF3C9, 0x2B80, 0x537A, 0x8B33,
+		0x553D, 0x8D74, 0xF58E, 0x2DC7, 0x047A, 0xDC33, 0xA4C9, 0x7C80,
+		0xF7B3, 0x2FFA, 0x5700, 0x8F49, 0xA6F4, 0x7EBD, 0x0647, 0xDE0E,
+		0xAA7A, 0x7233, 0x0AC9, 0xD280, 0xFB3D, 0x2374, 0x5B8E, 0x83C7,
+		0x08F4, 0xD0BD, 0xA847, 0x700E, 0x59B3, 0x81FA, 0xF900, 0x2149,
+		0xFF47, 0x270E, 0x5FF4, 0x87BD, 0xAE00, 0x7649, 0x0EB3, 0xD6FA,
+		0x5DC9, 0x8580, 0xFD7A, 0x2533, 0x0C8E, 0xD4C7, 0xAC3D, 0x7474,
+		0x44D5, 0x9C9C, 0xE466, 0x3C2F, 0x1592, 0xCDDB, 0xB521, 0x6D68,
+		0xE65B, 0x3E12, 0x46E8, 0x9EA1, 0xB71C, 0x6F55, 0x17AF, 0xCFE6,
+		0x11E8, 0xC9A1, 0xB15B, 0x6912, 0x40AF, 0x98E6, 0xE01C, 0x3855,
+		0xB366, 0x6B2F, 0x13D5, 0xCB9C, 0xE221, 0x3A68, 0x4292, 0x9ADB,
+		0xEEAF, 0x36E6, 0x4E1C, 0x9655, 0xBFE8, 0x67A1, 0x1F5B, 0xC712,
+		0x4C21, 0x9468, 0xEC92, 0x34DB, 0x1D66, 0xC52F, 0xBDD5, 0x659C,
+		0xBB92, 0x63DB, 0x1B21, 0xC368, 0xEAD5, 0x329C, 0x4A66, 0x922F,
+		0x191C, 0xC155, 0xB9AF, 0x61E6, 0x485B, 0x9012, 0xE8E8, 0x30A1,
+		0x89AA, 0x51E3, 0x2919, 0xF150, 0xD8ED, 0x00A4, 0x785E, 0xA017,
+		0x2B24, 0xF36D, 0x8B97, 0x53DE, 0x7A63, 0xA22A, 0xDAD0, 0x0299,
+		0xDC97, 0x04DE, 0x7C24, 0xA46D, 0x8DD0, 0x5599, 0x2D63, 0xF52A,
+		0x7E19, 0xA650, 0xDEAA, 0x06E3, 0x2F5E, 0xF717, 0x8FED, 0x57A4,
+		0x23D0, 0xFB99, 0x8363, 0x5B2A, 0x7297, 0xAADE, 0xD224, 0x0A6D,
+		0x815E, 0x5917, 0x21ED, 0xF9A4, 0xD019, 0x0850, 0x70AA, 0xA8E3,
+		0x76ED, 0xAEA4, 0xD65E, 0x0E17, 0x27AA, 0xFFE3, 0x8719, 0x5F50,
+		0xD463, 0x0C2A, 0x74D0, 0xAC99, 0x8524, 0x5D6D, 0x2597, 0xFDDE,
+		0xCD7F, 0x1536, 0x6DCC, 0xB585, 0x9C38, 0x4471, 0x3C8B, 0xE4C2,
+		0x6FF1, 0xB7B8, 0xCF42, 0x170B, 0x3EB6, 0xE6FF, 0x9E05, 0x464C,
+		0x9842, 0x400B, 0x38F1, 0xE0B8, 0xC905, 0x114C, 0x69B6, 0xB1FF,
+		0x3ACC, 0xE285, 0x9A7F, 0x4236, 0x6B8B, 0xB3C2, 0xCB38, 0x1371,
+		0x6705, 0xBF4C, 0xC7B6, 0x1FFF, 0x3642, 0xEE0B, 0x96F1, 0x4EB8,
+		0xC58B, 0x1DC2, 0x6538, 0xBD71, 0x94CC, 0x4C85, 0x347F, 0xEC36,
+		0x3238, 0xEA71, 0x928B, 0x4AC2, 0x637F, 0xBB36, 0xC3CC, 0x1B85,
+		0x90B6, 0x48FF, 0x3005, 0xE84C, 0xC1F1, 0x19B8, 0x6142, 0xB90B,
+	},
+	{	/* 11 */
+		0x0000, 0x0375, 0x06EA, 0x059F, 0x0DD4, 0x0EA1, 0x0B3E, 0x084B,
+		0x1BA8, 0x18DD, 0x1D42, 0x1E37, 0x167C, 0x1509, 0x1096, 0x13E3,
+		0x3750, 0x3425, 0x31BA, 0x32CF, 0x3A84, 0x39F1, 0x3C6E, 0x3F1B,
+		0x2CF8, 0x2F8D, 0x2A12, 0x2967, 0x212C, 0x2259, 0x27C6, 0x24B3,
+		0x6EA0, 0x6DD5, 0x684A, 0x6B3F, 0x6374, 0x6001, 0x659E, 0x66EB,
+		0x7508, 0x767D, 0x73E2, 0x7097, 0x78DC, 0x7BA9, 0x7E36, 0x7D43,
+		0x59F0, 0x5A85, 0x5F1A, 0x5C6F, 0x5424, 0x5751, 0x52CE, 0x51BB,
+		0x4258, 0x412D, 0x44B2, 0x47C7, 0x4F8C, 0x4CF9, 0x4966, 0x4A13,
+		0xDD40, 0xDE35, 0xDBAA, 0xD8DF, 0xD094, 0xD3E1, 0xD67E, 0xD50B,
+		0xC6E8, 0xC59D, 0xC002, 0xC377, 0xCB3C, 0xC849, 0xCDD6, 0xCEA3,
+		0xEA10, 0xE965, 0xECFA, 0xEF8F, 0xE7C4, 0xE4B1, 0xE12E, 0xE25B,
+		0xF1B8, 0xF2CD, 0xF752, 0xF427, 0xFC6C, 0xFF19, 0xFA86, 0xF9F3,
+		0xB3E0, 0xB095, 0xB50A, 0xB67F, 0xBE34, 0xBD41, 0xB8DE, 0xBBAB,
+		0xA848, 0xAB3D, 0xAEA2, 0xADD7, 0xA59C, 0xA6E9, 0xA376, 0xA003,
+		0x84B0, 0x87C5, 0x825A, 0x812F, 0x8964, 0x8A11, 0x8F8E, 0x8CFB,
+		0x9F18, 0x9C6D, 0x99F2, 0x9A87, 0x92CC, 0x91B9, 0x9426, 0x9753,
+		0xAAA1, 0xA9D4, 0xAC4B, 0xAF3E, 0xA775, 0xA400, 0xA19F, 0xA2EA,
+		0xB109, 0xB27C, 0xB7E3, 0xB496, 0xBCDD, 0xBFA8, 0xBA37, 0xB942,
+		0x9DF1, 0x9E84, 0x9B1B, 0x986E, 0x9025, 0x9350, 0x96CF, 0x95BA,
+		0x8659, 0x852C, 0x80B3, 0x83C6, 0x8B8D, 0x88F8, 0x8D67, 0x8E12,
+		0xC401, 0xC774, 0xC2EB, 0xC19E, 0xC9D5, 0xCAA0, 0xCF3F, 0xCC4A,
+		0xDFA9, 0xDCDC, 0xD943, 0xDA36, 0xD27D, 0xD108, 0xD497, 0xD7E2,
+		0xF351, 0xF024, 0xF5BB, 0xF6CE, 0xFE85, 0xFDF0, 0xF86F, 0xFB1A,
+		0xE8F9, 0xEB8C, 0xEE13, 0xED66, 0xE52D, 0xE658, 0xE3C7, 0xE0B2,
+		0x77E1, 0x7494, 0x710B, 0x727E, 0x7A35, 0x7940, 0x7CDF, 0x7FAA,
+		0x6C49, 0x6F3C, 0x6AA3, 0x69D6, 0x619D, 0x62E8, 0x6777, 0x6402,
+		0x40B1, 0x43C4, 0x465B, 0x452E, 0x4D65, 0x4E10, 0x4B8F, 0x48FA,
+		0x5B19, 0x586C, 0x5DF3, 0x5E86, 0x56CD, 0x55B8, 0x5027, 0x5352,
+		0x1941, 0x1A34, 0x1FAB, 0x1CDE, 0x1495, 0x17E0, 0x127F, 0x110A,
+		0x02E9, 0x019C, 0x0403, 0x0776, 0x0F3D, 0x0C48, 0x09D7, 0x0AA2,
+		0x2E11, 0x2D64, 0x28FB, 0x2B8E, 0x23C5, 0x20B0, 0x252F, 0x265A,
+		0x35B9, 0x36CC, 0x3353, 0x3026, 0x386D, 0x3B18, 0x3E87, 0x3DF2,
+	},
+	{	/* 12 */
+		0x0000, 0x4563, 0x8AC6, 0xCFA5, 0x05AD, 0x40CE, 0x8F6B, 0xCA08,
+		0x0B5A, 0x4E39, 0x819C, 0xC4FF, 0x0EF7, 0x4B94, 0x8431, 0xC152,
+		0x16B4, 0x53D7, 0x9C72, 0xD911, 0x1319, 0x567A, 0x99DF, 0xDCBC,
+		0x1DEE, 0x588D, 0x9728, 0xD24B, 0x1843, 0x5D20, 0x9285, 0xD7E6,
+		0x2D68, 0x680B, 0xA7AE, 0xE2CD, 0x28C5, 0x6DA6, 0xA203, 0xE760,
+		0x2632, 0x6351, 0xACF4, 0xE997, 0x239F, 0x66FC, 0xA959, 0xEC3A,
+		0x3BDC, 0x7EBF, 0xB11A, 0xF479, 0x3E71, 0x7B12, 0xB4B7, 0xF1D4,
+		0x3086, 0x75E5, 0xBA40, 0xFF23, 0x352B, 0x7048, 0xBFED, 0xFA8E,
+		0x5AD0, 0x1FB3, 0xD016, 0x9575, 0x5F7D, 0x1A1E, 0xD5BB, 0x90D8,
+		0x518A, 0x14E9, 0xDB4C, 0x9E2F, 0x5427, 0x1144, 0xDEE1, 0x9B82,
+		0x4C64, 0x0907, 0xC6A2, 0x83C1, 0x49C9, 0x0CAA, 0xC30F, 0x866C,
+		0x473E, 0x025D, 0xCDF8, 0x889B, 0x4293, 0x07F0, 0xC855, 0x8D36,
+		0x77B8, 0x32DB, 0xFD7E, 0xB81D, 0x7215, 0x3776, 0xF8D3, 0xBDB0,
+		0x7CE2, 0x3981, 0xF624, 0xB347, 0x794F, 0x3C2C, 0xF389, 0xB6EA,
+		0x610C, 0x246F, 0xEBCA, 0xAEA9, 0x64A1, 0x21C2, 0xEE67, 0xAB04,
+		0x6A56, 0x2F35, 0xE090, 0xA5F3, 0x6FFB, 0x2A98, 0xE53D, 0xA05E,
+		0xB5A0, 0xF0C3, 0x3F66, 0x7A05, 0xB00D, 0xF56E, 0x3ACB, 0x7FA8,
+		0xBEFA, 0xFB99, 0x343C, 0x715F, 0xBB57, 0xFE34, 0x3191, 0x74F2,
+		0xA314, 0xE677, 0x29D2, 0x6CB1, 0xA6B9, 0xE3DA, 0x2C7F, 0x691C,
+		0xA84E, 0xED2D, 0x2288, 0x67EB, 0xADE3, 0xE880, 0x2725, 0x6246,
+		0x98C8, 0xDDAB, 0x120E, 0x576D, 0x9D65, 0xD806, 0x17A3, 0x52C0,
+		0x9392, 0xD6F1, 0x1954, 0x5C37, 0x963F, 0xD35C, 0x1CF9, 0x599A,
+		0x8E7C, 0xCB1F, 0x04BA, 0x41D9, 0x8BD1, 0xCEB2, 0x0117, 0x4474,
+		0x8526, 0xC045, 0x0FE0, 0x4A83, 0x808B, 0xC5E8, 0x0A4D, 0x4F2E,
+		0xEF70, 0xAA13, 0x65B6, 0x20D5, 0xEADD, 0xAFBE, 0x601B, 0x2578,
+		0xE42A, 0xA149, 0x6EEC, 0x2B8F, 0xE187, 0xA4E4, 0x6B41, 0x2E22,
+		0xF9C4, 0xBCA7, 0x7302, 0x3661, 0xFC69, 0xB90A, 0x76AF, 0x33CC,
+		0xF29E, 0xB7FD, 0x7858, 0x3D3B, 0xF733, 0xB250, 0x7DF5, 0x3896,
+		0xC218, 0x877B, 0x48DE, 0x0DBD, 0xC7B5, 0x82D6, 0x4D73, 0x0810,
+		0xC942, 0x8C21, 0x4384, 0x06E7, 0xCCEF, 0x898C, 0x4629, 0x034A,
+		0xD4AC, 0x91CF, 0x5E6A, 0x1B09, 0xD101, 0x9462, 0x5BC7, 0x1EA4,
+		0xDFF6, 0x9A95, 0x5530, 0x1053, 0xDA5B, 0x9F38, 0x509D, 0x15FE,
+	},
+	{	/* 13 */
+		0x0000, 0x7B61, 0xF6C2, 0x8DA3, 0xFDA5, 0x86C4, 0x0B67, 0x7006,
+		0xEB6B, 0x900A, 0x1DA9, 0x66C8, 0x16CE, 0x6DAF, 0xE00C, 0x9B6D,
+		0xC6F7, 0xBD96, 0x3035, 0x4B54, 0x3B52, 0x4033, 0xCD90, 0xB6F1,
+		0x2D9C, 0x56FD, 0xDB5E, 0xA03F, 0xD039, 0xAB58, 0x26FB, 0x5D9A,
+		0x9DCF, 0xE6AE, 0x6B0D, 0x106C, 0x606A, 0x1B0B, 0x96A8, 0xEDC9,
+		0x76A4, 0x0DC5, 0x8066, 0xFB07, 0x8B01, 0xF060, 0x7DC3, 0x06A2,
+		0x5B38, 0x2059, 0xADFA, 0xD69B, 0xA69D, 0xDDFC, 0x505F, 0x2B3E,
+		0xB053, 0xCB32, 0x4691, 0x3DF0, 0x4DF6, 0x3697, 0xBB34, 0xC055,
+		0x2BBF, 0x50DE, 0xDD7D, 0xA61C, 0xD61A, 0xAD7B, 0x20D8, 0x5BB9,
+		0xC0D4, 0xBBB5, 0x3616, 0x4D77, 0x3D71, 0x4610, 0xCBB3, 0xB0D2,
+		0xED48, 0x9629, 0x1B8A, 0x60EB, 0x10ED, 0x6B8C, 0xE62F, 0x9D4E,
+		0x0623, 0x7D42, 0xF0E1, 0x8B80, 0xFB86, 0x80E7, 0x0D44, 0x7625,
+		0xB670, 0xCD11, 0x40B2, 0x3BD3, 0x4BD5, 0x30B4, 0xBD17, 0xC676,
+		0x5D1B, 0x267A, 0xABD9, 0xD0B8, 0xA0BE, 0xDBDF, 0x567C, 0x2D1D,
+		0x7087, 0x0BE6, 0x8645, 0xFD24, 0x8D22, 0xF643, 0x7BE0, 0x0081,
+		0x9BEC, 0xE08D, 0x6D2E, 0x164F, 0x6649, 0x1D28, 0x908B, 0xEBEA,
+		0x577E, 0x2C1F, 0xA1BC, 0xDADD, 0xAADB, 0xD1BA, 0x5C19, 0x2778,
+		0xBC15, 0xC774, 0x4AD7, 0x31B6, 0x41B0, 0x3AD1, 0xB772, 0xCC13,
+		0x9189, 0xEAE8, 0x674B, 0x1C2A, 0x6C2C, 0x174D, 0x9AEE, 0xE18F,
+		0x7AE2, 0x0183, 0x8C20, 0xF741, 0x8747, 0xFC26, 0x7185, 0x0AE4,
+		0xCAB1, 0xB1D0, 0x3C73, 0x4712, 0x3714, 0x4C75, 0xC1D6, 0xBAB7,
+		0x21DA, 0x5ABB, 0xD718, 0xAC79, 0xDC7F, 0xA71E, 0x2ABD, 0x51DC,
+		0x0C46, 0x7727, 0xFA84, 0x81E5, 0xF1E3, 0x8A82, 0x0721, 0x7C40,
+		0xE72D, 0x9C4C, 0x11EF, 0x6A8E, 0x1A88, 0x61E9, 0xEC4A, 0x972B,
+		0x7CC1, 0x07A0, 0x8A03, 0xF162, 0x8164, 0xFA05, 0x77A6, 0x0CC7,
+		0x97AA, 0xECCB, 0x6168, 0x1A09, 0x6A0F, 0x116E, 0x9CCD, 0xE7AC,
+		0xBA36, 0xC157, 0x4CF4, 0x3795, 0x4793, 0x3CF2, 0xB151, 0xCA30,
+		0x515D, 0x2A3C, 0xA79F, 0xDCFE, 0xACF8, 0xD799, 0x5A3A, 0x215B,
+		0xE10E, 0x9A6F, 0x17CC, 0x6CAD, 0x1CAB, 0x67CA, 0xEA69, 0x9108,
+		0x0A65, 0x7104, 0xFCA7, 0x87C6, 0xF7C0, 0x8CA1, 0x0102, 0x7A63,
+		0x27F9, 0x5C98, 0xD13B, 0xAA5A, 0xDA5C, 0xA13D, 0x2C9E, 0x57FF,
+		0xCC92, 0xB7F3, 0x3A50, 0x4131, 0x3137, 0x4A56, 0xC7F5, 0xBC94,
+	},
+	{	/* 14 */
+		0x0000, 0xAEFC, 0x4DD9, 0xE325, 0x9BB2, 0x354E, 0xD66B, 0x7897,
+		0x2745, 0x89B9, 0x6A9C, 0xC460, 0xBCF7, 0x120B, 0xF12E, 0x5FD2,
+		0x4E8A, 0xE076, 0x0353, 0xADAF, 0xD538, 0x7BC4, 0x98E1, 0x361D,
+		0x69CF, 0xC733, 0x2416, 0x8AEA, 0xF27D, 0x5C81, 0xBFA4, 0x1158,
+		0x9D14, 0x33E8, 0xD0CD, 0x7E31, 0x06A6, 0xA85A, 0x4B7F, 0xE583,
+		0xBA51, 0x14AD, 0xF788, 0x5974, 0x21E3, 0x8F1F, 0x6C3A, 0xC2C6,
+		0xD39E, 0x7D62, 0x9E47, 0x30BB, 0x482C, 0xE6D0, 0x05F5, 0xAB09,
+		0xF4DB, 0x5A27, 0xB902, 0x17FE, 0x6F69, 0xC195, 0x22B0, 0x8C4C,
+		0x2A09, 0x84F5, 0x67D0, 0xC92C, 0xB1BB, 0x1F47, 0xFC62, 0x529E,
+		0x0D4C, 0xA3B0, 0x4095, 0xEE69, 0x96FE, 0x3802, 0xDB27, 0x75DB,
+		0x6483, 0xCA7F, 0x295A, 0x87A6, 0xFF31, 0x51CD, 0xB2E8, 0x1C14,
+		0x43C6, 0xED3A, 0x0E1F, 0xA0E3, 0xD874, 0x7688, 0x95AD, 0x3B51,
+		0xB71D, 0x19E1, 0xFAC4, 0x5438, 0x2CAF, 0x8253, 0x6176, 0xCF8A,
+		0x9058, 0x3EA4, 0xDD81, 0x737D, 0x0BEA, 0xA516, 0x4633, 0xE8CF,
+		0xF997, 0x576B, 0xB44E, 0x1AB2, 0x6225, 0xCCD9, 0x2FFC, 0x8100,
+		0xDED2, 0x702E, 0x930B, 0x3DF7, 0x4560, 0xEB9C, 0x08B9, 0xA645,
+		0x5412, 0xFAEE, 0x19CB, 0xB737, 0xCFA0, 0x615C, 0x8279, 0x2C85,
+		0x7357, 0xDDAB, 0x3E8E, 0x9072, 0xE8E5, 0x4619, 0xA53C, 0x0BC0,
+		0x1A98, 0xB464, 0x5741, 0xF9BD, 0x812A, 0x2FD6, 0xCCF3, 0x620F,
+		0x3DDD, 0x9321, 0x7004, 0xDEF8, 0xA66F, 0x0893, 0xEBB6, 0x454A,
+		0xC906, 0x67FA, 0x84DF, 0x2A23, 0x52B4, 0xFC48, 0x1F6D, 0xB191,
+		0xEE43, 0x40BF, 0xA39A, 0x0D66, 0x75F1, 0xDB0D, 0x3828, 0x96D4,
+		0x878C, 0x2970, 0xCA55, 0x64A9, 0x1C3E, 0xB2C2, 0x51E7, 0xFF1B,
+		0xA0C9, 0x0E35, 0xED10, 0x43EC, 0x3B7B, 0x9587, 0x76A2, 0xD85E,
+		0x7E1B, 0xD0E7, 0x33C2, 0x9D3E, 0xE5A9, 0x4B55, 0xA870, 0x068C,
+		0x595E, 0xF7A2, 0x1487, 0xBA7B, 0xC2EC, 0x6C10, 0x8F35, 0x21C9,
+		0x3091, 0x9E6D, 0x7D48, 0xD3B4, 0xAB23, 0x05DF, 0xE6FA, 0x4806,
+		0x17D4, 0xB928, 0x5A0D, 0xF4F1, 0x8C66, 0x229A, 0xC1BF, 0x6F43,
+		0xE30F, 0x4DF3, 0xAED6, 0x002A, 0x78BD, 0xD641, 0x3564, 0x9B98,
+		0xC44A, 0x6AB6, 0x8993, 0x276F, 0x5FF8, 0xF104, 0x1221, 0xBCDD,
+		0xAD85, 0x0379, 0xE05C, 0x4EA0, 0x3637, 0x98CB, 0x7BEE, 0xD512,
+		0x8AC0, 0x243C, 0xC719, 0x69E5, 0x1172, 0xBF8E, 0x5CAB, 0xF257,
+	},
+	{	/* 15 */
+		0x0000, 0xA824, 0x4069, 0xE84D, 0x80D2, 0x28F6, 0xC0BB, 0x689F,
+		0x1185, 0xB9A1, 0x51EC, 0xF9C8, 0x9157, 0x3973, 0xD13E, 0x791A,
+		0x230A, 0x8B2E, 0x6363, 0xCB47, 0xA3D8, 0x0BFC, 0xE3B1, 0x4B95,
+		0x328F, 0x9AAB, 0x72E6, 0xDAC2, 0xB25D, 0x1A79, 0xF234, 0x5A10,
+		0x4614, 0xEE30, 0x067D, 0xAE59, 0xC6C6, 0x6EE2, 0x86AF, 0x2E8B,
+		0x5791, 0xFFB5, 0x17F8, 0xBFDC, 0xD743, 0x7F67, 0x972A, 0x3F0E,
+		0x651E, 0xCD3A, 0x2577, 0x8D53, 0xE5CC, 0x4DE8, 0xA5A5, 0x0D81,
+		0x749B, 0xDCBF, 0x34F2, 0x9CD6, 0xF449, 0x5C6D, 0xB420, 0x1C04,
+		0x8C28, 0x240C, 0xCC41, 0x6465, 0x0CFA, 0xA4DE, 0x4C93, 0xE4B7,
+		0x9DAD, 0x3589, 0xDDC4, 0x75E0, 0x1D7F, 0xB55B, 0x5D16, 0xF532,
+		0xAF22, 0x0706, 0xEF4B, 0x476F, 0x2FF0, 0x87D4, 0x6F99, 0xC7BD,
+		0xBEA7, 0x1683, 0xFECE, 0x56EA, 0x3E75, 0x9651, 0x7E1C, 0xD638,
+		0xCA3C, 0x6218, 0x8A55, 0x2271, 0x4AEE, 0xE2CA, 0x0A87, 0xA2A3,
+		0xDBB9, 0x739D, 0x9BD0, 0x33F4, 0x5B6B, 0xF34F, 0x1B02, 0xB326,
+		0xE936, 0x4112, 0xA95F, 0x017B, 0x69E4, 0xC1C0, 0x298D, 0x81A9,
+		0xF8B3, 0x5097, 0xB8DA, 0x10FE, 0x7861, 0xD045, 0x3808, 0x902C,
+		0x0871, 0xA055, 0x4818, 0xE03C, 0x88A3, 0x2087, 0xC8CA, 0x60EE,
+		0x19F4, 0xB1D0, 0x599D, 0xF1B9, 0x9926, 0x3102, 0xD94F, 0x716B,
+		0x2B7B, 0x835F, 0x6B12, 0xC336, 0xABA9, 0x038D, 0xEBC0, 0x43E4,
+		0x3AFE, 0x92DA, 0x7A97, 0xD2B3, 0xBA2C, 0x1208, 0xFA45, 0x5261,
+		0x4E65, 0xE641, 0x0E0C, 0xA628, 0xCEB7, 0x6693, 0x8EDE, 0x26FA,
+		0x5FE0, 0xF7C4, 0x1F89, 0xB7AD, 0xDF32, 0x7716, 0x9F5B, 0x377F,
+		0x6D6F, 0xC54B, 0x2D06, 0x8522, 0xEDBD, 0x4599, 0xADD4, 0x05F0,
+		0x7CEA, 0xD4CE, 0x3C83, 0x94A7, 0xFC38, 0x541C, 0xBC51, 0x1475,
+		0x8459, 0x2C7D, 0xC430, 0x6C14, 0x048B, 0xACAF, 0x44E2, 0xECC6,
+		0x95DC, 0x3DF8, 0xD5B5, 0x7D91, 0x150E, 0xBD2A, 0x5567, 0xFD43,
+		0xA753, 0x0F77, 0xE73A, 0x4F1E, 0x2781, 0x8FA5, 0x67E8, 0xCFCC,
+		0xB6D6, 0x1EF2, 0xF6BF, 0x5E9B, 0x3604, 0x9E20, 0x766D, 0xDE49,
+		0xC24D, 0x6A69, 0x8224, 0x2A00, 0x429F, 0xEABB, 0x02F6, 0xAAD2,
+		0xD3C8, 0x7BEC, 0x93A1, 0x3B85, 0x531A, 0xFB3E, 0x1373, 0xBB57,
+		0xE147, 0x4963, 0xA12E, 0x090A, 0x6195, 0xC9B1, 0x21FC, 0x89D8,
+		0xF0C2, 0x58E6, 0xB0AB, 0x188F, 0x7010, 0xD834, 0x3079, 0x985D,
+	},
+#endif
+};
+#endif
+
+#if (YM_CRC_CLMUL_ENABLED)
+/** Folding constants x^n mod P, for n = 576 and 512 (fold by 4), 192 and 128 (fold by 1) **/
+#define YM_CRC_K576		(0x8832)
+#define YM_CRC_K512		(0x13FC)
+#define YM_CRC_K192		(0x650B)
+#define YM_CRC_K128		(0xAEFC)
+/** Smallest buffer handed to the carry-less multiply kernel **/
+#define YM_CRC_CLMUL_MIN	(64)
+#endif
+
+/**
+ * @brief  				Software CRC-16/XMODEM kernel, continues from a previous CRC value.
+ *
+ * @param  crc			CRC of the preceding data, 0 to start
+ * @param  data			Buffer to be checked
+ * @param  size			Length of the buffer
+ * @return uint16_t		The updated CRC
+ */
+static uint16_t crc16Sw(uint16_t crc, const uint8_t *data, uint32_t size)
 {
-        uint16_t xor = crc_in >> 15;
-        uint16_t out = crc_in << 1;
+#if (YM_CRC_SLICE > 0)
+	const uint16_t (*t)[256] = crc16Slice;
 
-        if (incr)
-                out++;
+	while (size >= YM_CRC_SLICE) {
+		crc = t[YM_CRC_SLICE-1][(crc >> 8) ^ data[0]] ^ t[YM_CRC_SLICE-2][(crc & 0xFF) ^ data[1]] ^
+			  t[YM_CRC_SLICE-3][data[2]] ^ t[YM_CRC_SLICE-4][data[3]] ^
+			  t[YM_CRC_SLICE-5][data[4]] ^ t[YM_CRC_SLICE-6][data[5]] ^
+			  t[YM_CRC_SLICE-7][data[6]] ^ t[YM_CRC_SLICE-8][data[7]];
+#if (YM_CRC_SLICE == 16)
+		crc ^= t[7][data[8]]  ^ t[6][data[9]]  ^ t[5][data[10]] ^ t[4][data[11]] ^
+			   t[3][data[12]] ^ t[2][data[13]] ^ t[1][data[14]] ^ t[0][data[15]];
+#endif
+		data += YM_CRC_SLICE;
+		size -= YM_CRC_SLICE;
+	}
+#endif
 
-        if (xor)
-                out ^= YM_CRC_POLY;
+	while (size--) {
+#if (YM_CRC_TABLE_SIZE == 256)
+		crc = (crc << 8) ^ crc16Table[((crc >> 8) ^ *data++) & 0xFF];
+#else
+		crc = (crc << 4) ^ crc16Table[((crc >> 12) ^ (*data >> 4)) & 0x0F];
+		crc = (crc << 4) ^ crc16Table[((crc >> 12) ^ *data++) & 0x0F];
+#endif
+	}
 
-        return out;
+	return crc;
 }
 
+#if (YM_CRC_CLMUL_ENABLED)
+/**
+ * @brief  				CRC-16/XMODEM by carry-less multiplication folding.
+ * 						The buffer is read as big-endian 128-bit blocks and folded into a single
+ * 						128-bit remainder congruent to the message modulo the CRC polynomial.
+ * 						The remainder and the unfolded tail are then run through crc16Sw.
+ *
+ * @param  crc			CRC of the preceding data, 0 to start
+ * @param  data			Buffer to be checked, at least YM_CRC_CLMUL_MIN bytes
+ * @param  size			Length of the buffer
+ * @return uint16_t		The updated CRC
+ */
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16Clmul(uint16_t crc, const uint8_t *data, uint32_t size)
+{
+	const __m128i bswap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	const __m128i k4 = _mm_set_epi64x(YM_CRC_K576, YM_CRC_K512);
+	const __m128i k1 = _mm_set_epi64x(YM_CRC_K192, YM_CRC_K128);
+	__m128i x0, x1, x2, x3;
+	uint8_t rem[16];
 
-static uint16_t crc16(const uint8_t *data, uint16_t size)
+	x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data +  0)), bswap);
+	x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+	x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+	x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+	/* The previous CRC is xored into the first two message bytes */
+	x0 = _mm_xor_si128(x0, _mm_set_epi64x((long long)((uint64_t)crc << 48), 0));
+	data += 64;
+	size -= 64;
+
+#define FOLD(x, k, next)	_mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128((x), (k), 0x11), \
+								_mm_clmulepi64_si128((x), (k), 0x00)), (next))
+	while (size >= 64) {
+		x0 = FOLD(x0, k4, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data +  0)), bswap));
+		x1 = FOLD(x1, k4, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap));
+		x2 = FOLD(x2, k4, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap));
+		x3 = FOLD(x3, k4, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap));
+		data += 64;
+		size -= 64;
+	}
+	x0 = FOLD(x0, k1, x1);
+	x0 = FOLD(x0, k1, x2);
+	x0 = FOLD(x0, k1, x3);
+	while (size >= 16) {
+		x0 = FOLD(x0, k1, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), bswap));
+		data += 16;
+		size -= 16;
+	}
+#undef FOLD
+
+	_mm_storeu_si128((__m128i *)rem, _mm_shuffle_epi8(x0, bswap));
+	return crc16Sw(crc16Sw(0, rem, sizeof(rem)), data, size);
+}
+#endif
+
+/**
+ * @brief  				Computes the CRC-16/XMODEM (poly 0x1021, init 0) of a buffer with the
+ * 						software kernels. This is the default CRC provider and the reference
+ * 						used by ymodem_CheckCrcFxn.
+ *
+ * @param  ctx			Unused
+ * @param  crc			CRC of the preceding data, 0 to start
+ * @param  data			Buffer to be checked
+ * @param  len			Length of the buffer
+ * @return uint16_t		The updated CRC
+ */
+uint16_t ymodem_Crc16(void *ctx, uint16_t crc, const uint8_t *data, uint32_t len)
 {
-        uint16_t crc, i;
+	(void)ctx;
+#if (YM_CRC_CLMUL_ENABLED)
+	/* The CPU model is filled in by the runtime before main, reading it needs no lock */
+	if ((len >= YM_CRC_CLMUL_MIN) && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+		return crc16Clmul(crc, data, len);
+	}
+#endif
+	return crc16Sw(crc, data, len);
+}
 
-        for (crc = 0; size > 0; size--, data++)
-                for (i = 0x80; i; i >>= 1)
-                        crc = crc_update(crc, *data & i);
+/**
+ * @brief  				Runs data through the instance CRC provider, or the software kernels if
+ * 						none is registered.
+ */
+static uint16_t ymodem_CrcUpdate(ymodem_t *ymodem, uint16_t crc, const uint8_t *data, uint32_t len)
+{
+	if (ymodem->crcFxn != NULL) {
+		return ymodem->crcFxn(ymodem->crcCtx, crc, data, len);
+	}
+	return ymodem_Crc16(NULL, crc, data, len);
+}
 
-        for (i = 0; i < 16; i++)
-                crc = crc_update(crc, 0);
+/**
+ * @brief  				Registers the CRC provider of the instance, e.g. a hardware CRC unit.
+ * 						The provider must compute CRC-16/XMODEM (poly 0x1021, no reflection,
+ * 						no final xor) continuing from the given crc. Check it with
+ * 						ymodem_CheckCrcFxn before starting a transfer.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @param  fxn			CRC provider, NULL to go back to the software kernels
+ * @param  ctx			Context handed to the provider
+ */
+void ymodem_SetCrcFxn(ymodem_t *ymodem, ymodem_crc_fxn_t fxn, void *ctx)
+{
+	assert (ymodem != NULL);
 
-        return crc;
+	ymodem->crcFxn = fxn;
+	ymodem->crcCtx = ctx;
+}
+
+/**
+ * @brief  				Conformance check of the registered CRC provider against the software
+ * 						reference. Uses 128 and 1024 byte payloads shaped like block 0, full
+ * 						data packets, padded last packets and erased (0xFF) data. The data is
+ * 						built 128 bytes at a time on the stack and chained through the provider,
+ * 						each chunk in one call and split in two, so the packet buffers are left
+ * 						alone and it can run at any time on a small stack.
+ *
+ * @param  ymodem		Ymodem instance.
+ * @return YMODEM_T 	YMODEM_OK if the provider matches, YMODEM_CRC_ERR otherwise.
+ */
+ymodem_err_e ymodem_CheckCrcFxn(ymodem_t *ymodem)
+{
+	static const uint16_t sizes[] = { YM_PACKET_SIZE, YM_PACKET_1K_SIZE };
+	static const char header[] = "firmware.bin\0" "123456 14371573112 100644 0";
+	uint8_t buf[YM_PACKET_SIZE];
+	uint32_t seed = 0x2545F491;
+	uint16_t ref, whole, parts;
+	uint16_t i, n, pos, size, split;
+	uint8_t shape;
+
+	assert (ymodem != NULL);
+
+	for (n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++) {
+		size = sizes[n];
+		for (shape = 0; shape < 4; shape++) {
+			ref = whole = parts = 0;
+			for (pos = 0; pos < size; pos += YM_PACKET_SIZE) {
+				for (i = 0; i < YM_PACKET_SIZE; i++) {
+					seed = seed * 1103515245 + 12345;
+					switch (shape) {
+						case 0: /* Full data packet */
+							buf[i] = (uint8_t)(seed >> 16);
+							break;
+						case 1: /* Block 0 */
+							buf[i] = (pos + i < sizeof(header)) ? (uint8_t)header[pos + i] : 0;
+							break;
+						case 2: /* Last packet, padded with SUB */
+							buf[i] = (pos + i < size / 3) ? (uint8_t)(seed >> 16) : 0x1A;
+							break;
+						default: /* Erased flash image */
+							buf[i] = 0xFF;
+							break;
+					}
+				}
+				/* A different split in every chunk, from 1 byte on */
+				split = 1 + (pos / YM_PACKET_SIZE * 37 + shape * 11) % (YM_PACKET_SIZE - 1);
+				ref = crc16Sw(ref, buf, YM_PACKET_SIZE);
+				whole = ymodem_CrcUpdate(ymodem, whole, buf, YM_PACKET_SIZE);
+				parts = ymodem_CrcUpdate(ymodem, parts, buf, split);
+				parts = ymodem_CrcUpdate(ymodem, parts, buf + split, YM_PACKET_SIZE - split);
+			}
+			if ((whole != ref) || (parts != ref)) {
+				return YMODEM_CRC_ERR;
+			}
+		}
+	}
+	return YMODEM_OK;
 }
 
 static ym_ret_t ymodem_CheckCRC(ymodem_t *ymodem) {
@@ -472,10 +3552,294 @@ static ym_ret_t ymodem_CheckCRC(ymodem_t *ymodem) {
 	sourceCRC = ymodem->packetData[(ymodem->packetSize+YM_PACKET_OVERHEAD) - 1];
 	sourceCRC = (sourceCRC << 8) | ymodem->packetData[(ymodem->packetSize+YM_PACKET_OVERHEAD) - 2];
 
-	uint16_t newCRC = SWAP16(crc16(ymodem->packetData+YM_PACKET_HEADER, ymodem->packetSize));
+#if (YM_CRC_INCREMENTAL > 0)
+	uint16_t newCRC = Swap16(ymodem->crc);
+#else
+	uint16_t newCRC = Swap16(ymodem_CrcUpdate(ymodem, 0, ymodem->packetData+YM_PACKET_HEADER, ymodem->packetSize));
+#endif
 	if (newCRC != sourceCRC) {
 		return YM_RX_ERROR;
 	} else {
 		return YM_OK;
 	}
 }
+
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+#if (YM_CRC_TABLE_SIZE == 256)
+/** CRC-32 (reflected, poly 0xEDB88320) lookup table, one entry per byte value **/
+static const uint32_t crc32Table[256] = {
+	0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+	0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+	0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+	0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+	0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+	0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+	0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+	0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+	0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+	0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+	0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+	0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+	0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+	0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+	0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+	0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+	0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+	0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+	0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+	0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+	0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+	0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+	0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+	0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+	0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+	0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+	0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+	0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+	0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+	0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+	0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+	0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+	0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+	0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+	0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+	0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+	0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+	0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+	0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+	0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+	0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+	0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+	0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+#else
+/** CRC-32 (reflected, poly 0xEDB88320) lookup table, one entry per nibble value **/
+static const uint32_t crc32Table[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+	0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+	0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+#endif
+
+/**
+ * @brief  				CRC-32 as zlib's crc32(): continues from the CRC of the data before, 0 to start.
+ *
+ * @param  crc			CRC-32 of the data before
+ * @param  data			Data
+ * @param  len			Bytes of data
+ * @return uint32_t		CRC-32 of the data before and data
+ */
+uint32_t ymodem_Crc32(uint32_t crc, const uint8_t *data, uint32_t len) {
+	crc = ~crc;
+	while (len--) {
+#if (YM_CRC_TABLE_SIZE == 256)
+		crc = crc32Table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+#else
+		crc ^= *data++;
+		crc = crc32Table[crc & 0x0F] ^ (crc >> 4);
+		crc = crc32Table[crc & 0x0F] ^ (crc >> 4);
+#endif
+	}
+	return ~crc;
+}
+#endif
+
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+#define ROTR32(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+/** SHA-256 round constants, the first 32 bits of the cube roots of the first 64 primes **/
+static const uint32_t sha256K[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+/**
+ * @brief  				Runs one 64 byte block through the SHA-256 compression function.
+ */
+static void ymodem_Sha256Block(ymodem_sha256_t *ctx, const uint8_t *block) {
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) | ((uint32_t)block[4 * i + 2] << 8) | block[4 * i + 3];
+	}
+	for (i = 16; i < 64; i++) {
+		t1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		t2 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		w[i] = t1 + w[i - 7] + t2 + w[i - 16];
+	}
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+	f = ctx->state[5];
+	g = ctx->state[6];
+	h = ctx->state[7];
+	for (i = 0; i < 64; i++) {
+		t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + sha256K[i] + w[i];
+		t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	ctx->state[0] += a;
+	ctx->state[1] += b;
+	ctx->state[2] += c;
+	ctx->state[3] += d;
+	ctx->state[4] += e;
+	ctx->state[5] += f;
+	ctx->state[6] += g;
+	ctx->state[7] += h;
+}
+
+/**
+ * @brief  				Starts a SHA-256.
+ *
+ * @param  ctx			SHA-256 context
+ */
+void ymodem_Sha256Init(ymodem_sha256_t *ctx) {
+	assert (ctx != NULL);
+
+	ctx->state[0] = 0x6A09E667;
+	ctx->state[1] = 0xBB67AE85;
+	ctx->state[2] = 0x3C6EF372;
+	ctx->state[3] = 0xA54FF53A;
+	ctx->state[4] = 0x510E527F;
+	ctx->state[5] = 0x9B05688C;
+	ctx->state[6] = 0x1F83D9AB;
+	ctx->state[7] = 0x5BE0CD19;
+	ctx->count = 0;
+}
+
+/**
+ * @brief  				Adds data to a SHA-256. Whole blocks are hashed straight from data.
+ *
+ * @param  ctx			SHA-256 context
+ * @param  data			Data
+ * @param  len			Bytes of data
+ */
+void ymodem_Sha256Update(ymodem_sha256_t *ctx, const uint8_t *data, uint32_t len) {
+	uint32_t used = ctx->count % 64;
+	uint32_t n;
+
+	ctx->count += len;
+	if (used > 0) {
+		n = ((64 - used) < len) ? (64 - used) : len;
+		memcpy(ctx->block + used, data, n);
+		data += n;
+		len -= n;
+		if (used + n < 64) {
+			return;
+		}
+		ymodem_Sha256Block(ctx, ctx->block);
+	}
+	while (len >= 64) {
+		ymodem_Sha256Block(ctx, data);
+		data += 64;
+		len -= 64;
+	}
+	memcpy(ctx->block, data, len);
+}
+
+/**
+ * @brief  				Pads the data hashed and gives its SHA-256.
+ *
+ * @param  ctx			SHA-256 context, to be started again before reuse
+ * @param  digest		SHA-256, 32 bytes
+ */
+void ymodem_Sha256Final(ymodem_sha256_t *ctx, uint8_t digest[32]) {
+	uint32_t used = ctx->count % 64;
+	uint32_t bits = ctx->count << 3;
+	int i;
+
+	ctx->block[used++] = 0x80;
+	if (used > 56) {
+		memset(ctx->block + used, 0, 64 - used);
+		ymodem_Sha256Block(ctx, ctx->block);
+		used = 0;
+	}
+	memset(ctx->block + used, 0, 64 - used);
+	/* Length in bits, big endian on 64 bits. The count is 32 bits, so the top 29 are 0 */
+	ctx->block[59] = (uint8_t)(ctx->count >> 29);
+	ctx->block[60] = (uint8_t)(bits >> 24);
+	ctx->block[61] = (uint8_t)(bits >> 16);
+	ctx->block[62] = (uint8_t)(bits >> 8);
+	ctx->block[63] = (uint8_t)bits;
+	ymodem_Sha256Block(ctx, ctx->block);
+	for (i = 0; i < 8; i++) {
+		digest[4 * i]		= (uint8_t)(ctx->state[i] >> 24);
+		digest[4 * i + 1]	= (uint8_t)(ctx->state[i] >> 16);
+		digest[4 * i + 2]	= (uint8_t)(ctx->state[i] >> 8);
+		digest[4 * i + 3]	= (uint8_t)ctx->state[i];
+	}
+}
+#endif
+
+#if (YM_DIGEST > 0)
+/**
+ * @brief  				Starts the digests of a new file.
+ */
+static void ymodem_DigestStart(ymodem_t *ymodem) {
+	ymodem->digestStatus = YMODEM_DIGEST_NONE;
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+	ymodem->crc32 = 0;
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+	ymodem_Sha256Init(&ymodem->sha256Ctx);
+#endif
+}
+
+/**
+ * @brief  				Adds file data to the digests, just before it is given to YMODEM_FILE_CB_DATA.
+ */
+static void ymodem_DigestUpdate(ymodem_t *ymodem, const uint8_t *data, uint32_t len) {
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+	ymodem->crc32 = ymodem_Crc32(ymodem->crc32, data, len);
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+	ymodem_Sha256Update(&ymodem->sha256Ctx, data, len);
+#endif
+}
+
+/**
+ * @brief  				Completes the digests at the end of the file, and compares them with the ones
+ * 						block 0 gave. After a resume they only cover the data received since.
+ */
+static void ymodem_DigestFinish(ymodem_t *ymodem) {
+	uint8_t given = ymodem->digestGiven & YM_DIGEST;
+	uint8_t same = 1;
+
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+	ymodem_Sha256Final(&ymodem->sha256Ctx, ymodem->sha256);
+	if (given & YM_DIGEST_SHA256) {
+		same = same && (memcmp(ymodem->sha256, ymodem->sha256Given, sizeof(ymodem->sha256)) == 0);
+	}
+#endif
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+	if (given & YM_DIGEST_CRC32) {
+		same = same && (ymodem->crc32 == ymodem->crc32Given);
+	}
+#endif
+#if (YM_RESUME > 0)
+	if (ymodem->resumeAt > 0) {
+		given = 0;
+	}
+#endif
+	if (given != 0) {
+		ymodem->digestStatus = same ? YMODEM_DIGEST_MATCH : YMODEM_DIGEST_MISMATCH;
+	}
+}
+#endif
@@ -28,8 +28,164 @@
 #define YM_FILE_SIZE_LENGTH			(16)
 #endif
 
+/** Longest answer to the sender: 5 bytes, 6 with YM_WINDOW (ACK seq ~seq NAK seq ~seq),
+ *  13 with YM_RESUME (block 0 answer carrying the resume offset), one more with YM_LZ **/
 #ifndef YM_RESP_PAYLOAD_LEN
-#define YM_RESP_PAYLOAD_LEN			(5)
+#define YM_RESP_PAYLOAD_LEN			(((YM_RESUME > 0) ? 13 : ((YM_WINDOW > 0) ? 6 : 5)) + ((YM_LZ > 0) ? 1 : 0))
+#endif
+
+/** CRC-16 lookup table entries: 256 (512 bytes of flash, one lookup per byte)
+ *  or 16 (32 bytes of flash, two lookups per byte) **/
+#ifndef YM_CRC_TABLE_SIZE
+#define YM_CRC_TABLE_SIZE			(256)
+#endif
+
+/** CRC-16 slicing factor for host builds: 0 (plain table), 8 or 16 bytes per step.
+ *  Slicing tables are const, YM_CRC_SLICE * 512 bytes of flash, nothing is built at run time **/
+#ifndef YM_CRC_SLICE
+#define YM_CRC_SLICE				(0)
+#endif
+
+/** Set to 1 on x86-64 host builds (GCC/Clang) to use a PCLMULQDQ folding CRC-16 kernel when
+ *  the CPU supports it. Falls back to the table kernel at run time otherwise **/
+#ifndef YM_CRC_CLMUL
+#define YM_CRC_CLMUL				(0)
+#endif
+
+/** Set to 1 to update the payload CRC as each byte is stored, so the check on the last byte
+ *  of a packet is a single compare instead of a pass over the whole payload **/
+#ifndef YM_CRC_INCREMENTAL
+#define YM_CRC_INCREMENTAL			(0)
+#endif
+
+/** Set to 1 to receive into two packet buffers inside ymodem_t, so the next packet is
+ *  assembled while the application drains the previous one (see ymodem_ReleaseBuffer) **/
+#ifndef YM_DOUBLE_BUFFER
+#define YM_DOUBLE_BUFFER			(0)
+#endif
+
+/** Set to 1 to receive into buffers owned by the application (see ymodem_SubmitBuffer)
+ *  instead of the packetData array inside ymodem_t **/
+#ifndef YM_ZERO_COPY
+#define YM_ZERO_COPY				(YM_DOUBLE_BUFFER)
+#endif
+
+#if (YM_DOUBLE_BUFFER > 0) && (YM_ZERO_COPY == 0)
+#error "YM_DOUBLE_BUFFER is built on YM_ZERO_COPY"
+#endif
+
+/** Largest sliding window the receiver accepts (packets in flight), 0 to refuse the window
+ *  extension. Costs (YM_WINDOW - 1) reorder slots of 1K in ymodem_t, at most 127 **/
+#ifndef YM_WINDOW
+#define YM_WINDOW					(0)
+#endif
+
+#if (YM_WINDOW == 1) || (YM_WINDOW > 127)
+#error "YM_WINDOW must be 0 or between 2 and 127"
+#endif
+
+#if (YM_WINDOW > 0) && (YM_ZERO_COPY > 0)
+#error "YM_WINDOW reorders into its own slots and can not be used with YM_ZERO_COPY"
+#endif
+
+#if (YM_WINDOW > 0) && (YM_RESP_PAYLOAD_LEN < 6)
+#error "YM_WINDOW needs YM_RESP_PAYLOAD_LEN of 6 or more"
+#endif
+
+/** Set to 1 to resume an interrupted file from the bytes the application has committed
+ *  (see ymodem_Resume), when the sender offers it in block 0 **/
+#ifndef YM_RESUME
+#define YM_RESUME					(0)
+#endif
+
+#if (YM_RESUME > 0) && (YM_RESP_PAYLOAD_LEN < 13)
+#error "YM_RESUME needs YM_RESP_PAYLOAD_LEN of 13 or more"
+#endif
+
+/** Set to 1 to accept (and, with YM_SENDER, offer) LZ compressed data packets, negotiated in
+ *  block 0. The history window is 1 << YM_LZ_WINDOW_BITS bytes (8 to 12) on both sides **/
+#ifndef YM_LZ
+#define YM_LZ						(0)
+#endif
+
+#ifndef YM_LZ_WINDOW_BITS
+#define YM_LZ_WINDOW_BITS			(10)
+#endif
+
+#if (YM_LZ > 0) && ((YM_LZ_WINDOW_BITS < 8) || (YM_LZ_WINDOW_BITS > 12))
+#error "YM_LZ_WINDOW_BITS must be 8 to 12"
+#endif
+
+#if (YM_LZ > 0) && (YM_RESP_PAYLOAD_LEN < ((YM_RESUME > 0) ? 14 : 6))
+#error "YM_LZ needs YM_RESP_PAYLOAD_LEN of 6 or more, 14 or more with YM_RESUME"
+#endif
+
+#if (YM_LZ > 0) && (YM_ZERO_COPY > 0)
+#error "YM_LZ delivers data from its history window, it can not be combined with YM_ZERO_COPY"
+#endif
+
+/** Digest of each file received, computed as its data is delivered: 0 for none, YM_DIGEST_CRC32,
+ *  YM_DIGEST_SHA256 or both ORed. It is ready at YMODEM_FILE_CB_END and compared with the one the
+ *  sender gives in block 0 (see ymodem_TxSetDigest) **/
+#ifndef YM_DIGEST
+#define YM_DIGEST					(0)
+#endif
+
+#define YM_DIGEST_CRC32				(0x01)		/* CRC-32 as zlib, Ethernet and PNG (reflected poly 0xEDB88320) */
+#define YM_DIGEST_SHA256			(0x02)		/* SHA-256 (FIPS 180-4) */
+
+#if (YM_DIGEST > (YM_DIGEST_CRC32 | YM_DIGEST_SHA256))
+#error "YM_DIGEST must be 0, YM_DIGEST_CRC32, YM_DIGEST_SHA256 or both"
+#endif
+
+/** Set to 1 to build the sender (ymodem_tx_t), which pulls file data from ymodem_TxReadCallback **/
+#ifndef YM_SENDER
+#define YM_SENDER					(0)
+#endif
+
+/** Receiver timing, see ymodem_Tick. 'C' (or 'G') is sent every YM_START_POLL_MS while waiting for
+ *  block 0, a packet stalled for YM_BYTE_TIMEOUT_MS is dropped and NAKed, and a NAK is sent when
+ *  no packet starts within YM_PACKET_TIMEOUT_MS of the last answer **/
+#ifndef YM_START_POLL_MS
+#define YM_START_POLL_MS			(1000)
+#endif
+#ifndef YM_BYTE_TIMEOUT_MS
+#define YM_BYTE_TIMEOUT_MS			(100)
+#endif
+#ifndef YM_PACKET_TIMEOUT_MS
+#define YM_PACKET_TIMEOUT_MS		(1000)
+#endif
+
+/** Whole session time after which ymodem_Tick cancels the transfer, 0 for no limit **/
+#ifndef YM_SESSION_TIMEOUT_MS
+#define YM_SESSION_TIMEOUT_MS		(0)
+#endif
+
+/** NAKs sent for the same packet before the receiver gives up and cancels the transfer,
+ *  multiplied by the window when one is agreed **/
+#ifndef YM_RX_RETRY_LIMIT
+#define YM_RX_RETRY_LIMIT			(10)
+#endif
+
+/** NAKs accepted for the same packet before the sender gives up and cancels the transfer,
+ *  multiplied by the window when one is agreed **/
+#ifndef YM_TX_RETRY_LIMIT
+#define YM_TX_RETRY_LIMIT			(10)
+#endif
+
+/** Sender with YM_LZ: file bytes read for each compressed packet (the most it can carry), and
+ *  entries of the match finder hash **/
+#ifndef YM_LZ_INPUT
+#define YM_LZ_INPUT					(4 * YM_PACKET_MAX_SIZE)
+#endif
+
+#ifndef YM_LZ_HASH_BITS
+#define YM_LZ_HASH_BITS				(10)
+#endif
+
+/** Maximum number of submitted buffers waiting to be filled **/
+#ifndef YM_BUFFER_POOL_DEPTH
+#define YM_BUFFER_POOL_DEPTH		(4)
 #endif
 
 /** Regular packet size **/
@@ -46,6 +202,31 @@
 
 #define YM_PACKET_1K_OVRHD_SIZE		(YM_PACKET_1K_SIZE + YM_PACKET_OVERHEAD)
 
+/** Largest data packet, 4096 or 8192 to offer large blocks in block 0. Every packet buffer
+ *  (ymodem_t, ymodem_tx_t and the ones given to ymodem_SubmitBuffer) is sized for it **/
+#ifndef YM_PACKET_MAX_SIZE
+#define YM_PACKET_MAX_SIZE			(YM_PACKET_1K_SIZE)
+#endif
+
+#if (YM_PACKET_MAX_SIZE != 1024) && (YM_PACKET_MAX_SIZE != 2048) && (YM_PACKET_MAX_SIZE != 4096) && (YM_PACKET_MAX_SIZE != 8192)
+#error "YM_PACKET_MAX_SIZE must be 1024, 2048, 4096 or 8192"
+#endif
+
+#define YM_PACKET_MAX_OVRHD_SIZE	(YM_PACKET_MAX_SIZE + YM_PACKET_OVERHEAD)
+
+#if (YM_LZ > 0) && ((YM_LZ_INPUT < YM_PACKET_MAX_SIZE) || ((1 << YM_LZ_WINDOW_BITS) + YM_LZ_INPUT > 0xFFFF))
+#error "YM_LZ_INPUT must hold a packet, and the sender's history window and input must fit in 64K"
+#endif
+
+/** Noise bytes swallowed between packets before a NAK is sent anyway, when the
+ *  application does not report the quiet line with ymodem_LineIdle **/
+#ifndef YM_PURGE_LIMIT
+#define YM_PURGE_LIMIT				(YM_PACKET_MAX_OVRHD_SIZE)
+#endif
+
+/** Start of the packet buffer holding the data given by YMODEM_FILE_CB_DATA **/
+#define YM_PACKET_BUFFER(data)		((uint8_t *)(data) - YM_PACKET_HEADER)
+
 #define YM_INSTANCE_INIT_MASK		0x52
 
 /*
@@ -63,6 +244,9 @@ typedef enum {
 	YMODEM_WRITE_ERR,		/* Error writing to flash */
 	YMODEM_SIZE_ERR,		/* File is bigger than flash */
 	YMODEM_COMPLETE,		/* Transfer completed succesfully */
+	YMODEM_PENDING,			/* Callback completes later / response held, nothing to transmit */
+	YMODEM_CRC_ERR,			/* CRC provider does not match the reference */
+	YMODEM_TIMEOUT,			/* Retry limit or session timeout reached, transfer cancelled */
 } ymodem_err_e;
 
 typedef enum{
@@ -72,38 +256,211 @@ typedef enum{
 	YMODEM_FILE_CB_ABORTED
 } ymodem_file_cb_e;
 
+typedef enum{
+	YMODEM_DIGEST_NONE,		/* No digest from the sender, or the file was resumed */
+	YMODEM_DIGEST_MATCH,	/* The digests from the sender match the file received */
+	YMODEM_DIGEST_MISMATCH	/* At least one does not */
+} ymodem_digest_e;
+
 /*
  * Typedefs
  */
 
 typedef uint8_t (*ymodem_fxn_t)(uint8_t *data, uint32_t len);
+/** CRC-16/XMODEM provider: returns the CRC of data continuing from crc (0 to start) **/
+typedef uint16_t (*ymodem_crc_fxn_t)(void *ctx, uint16_t crc, const uint8_t *data, uint32_t len);
 
 /*
  * structs
  */
 
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+typedef struct{
+	uint32_t	state[8];								/** Hash state **/
+	uint32_t	count;									/** Bytes hashed **/
+	uint8_t		block[64];								/** Bytes of the block being filled **/
+} ymodem_sha256_t;
+#endif
+
 typedef struct{
 	uint8_t 	fileName[YM_FILE_NAME_LENGTH];			/** Incoming file filename **/
 	uint8_t 	fileSizeStr[YM_FILE_SIZE_LENGTH];		/** Incoming file size string **/
-	uint8_t 	packetData[YM_PACKET_1K_OVRHD_SIZE];	/** Packet Data to hold the received data **/
+#if (YM_ZERO_COPY > 0)
+	uint8_t		*packetData;							/** Application buffer holding the current packet **/
+	uint8_t		*bufPool[YM_BUFFER_POOL_DEPTH];			/** Submitted buffers waiting to be filled **/
+	uint8_t		bufHead;								/** Index of the next buffer in bufPool **/
+	uint8_t		bufCount;								/** Number of buffers in bufPool **/
+#endif
+#if (YM_DOUBLE_BUFFER > 0)
+	uint8_t		packetBuf[2][YM_PACKET_MAX_OVRHD_SIZE];	/** Packet buffers, one filling while the other drains **/
+	uint8_t		bufOut;									/** Bit n set while packetBuf[n] is with the application **/
+#elif (YM_ZERO_COPY == 0)
+	uint8_t 	packetData[YM_PACKET_MAX_OVRHD_SIZE];	/** Packet Data to hold the received data **/
+#endif
 	uint8_t		payloadTx[YM_RESP_PAYLOAD_LEN];			/** Payload to response the host **/
 	uint8_t		payloadLen;								/** Length of the payload to send **/
 	uint8_t 	initialized;							/** Initialized flag **/
 	uint32_t 	fileSize;								/** File size as int **/
+	uint8_t		fileSizeKnown;							/** Block 0 had a valid size, the last packet is cut to it **/
+	uint32_t	fileMtime;								/** Modification time from block 0, seconds since 1970, 0 if not sent **/
+	uint32_t	fileMode;								/** Unix file mode from block 0, 0 if not sent **/
+	uint32_t	fileSerial;								/** Serial number of the sending program from block 0, 0 if not sent **/
+	uint32_t	fileOffset;								/** File offset of the data given to YMODEM_FILE_CB_DATA, bytes delivered after it **/
 	uint8_t 	prevC;									/** Previous byte character inputted **/
 	uint8_t 	startOfPacket; 							/** Whether data is start of a packet **/
-	uint8_t 	eotReceived; 							/** Expect one more packet after this to signal end **/
+	uint8_t 	eotReceived; 							/** First EOT NAKed, the second one ends the file **/
 	uint16_t 	packetBytes; 							/** # of Bytes received of current packet **/
 	uint16_t 	packetSize;								/** Size of current packet **/
-	int32_t 	packetsReceived;						/** Num packets received **/
+	int32_t 	packetsReceived;						/** Num packets received for the current file **/
+	uint16_t	filesReceived;							/** Num files completed in this session **/
+	uint8_t		txHeld;									/** Response held until the application releases it **/
+	uint8_t		heldRet;								/** Held response **/
+	uint8_t		cbPending;								/** A callback returned YMODEM_PENDING **/
+	uint8_t		resync;									/** Discarding a broken packet or noise until a header or a quiet line **/
+	uint8_t		syncWin[3];								/** Last bytes seen while resynchronizing **/
+	uint16_t	discardLeft;							/** Bytes to discard before giving up and sending NAK **/
+	uint8_t		streaming;								/** YMODEM-G, no ACK per packet and errors abort **/
+	uint8_t		extCaps;								/** Block 0 extensions accepted for the current file **/
+	uint8_t		retries;								/** NAKs sent for packet retryPkt **/
+	int32_t		retryPkt;								/** Packet the NAKs were sent for **/
+	uint32_t	duplicates;								/** Retransmitted packets ACKed again without a callback **/
+	uint32_t	idleMs;									/** Time since the last byte in or out, see ymodem_Tick **/
+	uint32_t	sessionMs;								/** Time since the session started, see ymodem_Tick **/
+#if (YM_WINDOW > 0)
+	uint8_t		window;									/** Packets in flight agreed in block 0, 0 for stop-and-wait **/
+	int16_t		nakSeq;									/** Packet to NAK, -1 for the first missing one **/
+	uint8_t		eotSeq;									/** Sequence of the EOT, answered with ACK eotSeq ~eotSeq 'C' **/
+	int32_t		gapNaked;								/** Missing packet already NAKed once **/
+	int32_t		slotPkt[YM_WINDOW - 1];					/** Packet held by each reorder slot, 0 if free **/
+	uint16_t	slotSize[YM_WINDOW - 1];				/** Payload size of each reorder slot **/
+	uint8_t		slotData[YM_WINDOW - 1][YM_PACKET_1K_SIZE];	/** Packets received ahead of a missing one **/
+#endif
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	uint16_t	largeSize;								/** Large block size agreed in block 0, 0 for 1K packets only **/
+#endif
+#if (YM_RESUME > 0)
+	uint8_t		resumeOk;								/** The sender offered resume for the current file **/
+	uint32_t	resumeAt;								/** File offset the transfer resumed from **/
+#endif
+#if (YM_LZ > 0)
+	uint8_t		lzBits;									/** LZ window bits agreed in block 0, 0 for plain packets **/
+	uint16_t	lzPos;									/** Next position written in lzRing **/
+	uint8_t		lzRing[1 << YM_LZ_WINDOW_BITS];			/** File data decompressed last, matches copy from it **/
+#endif
+#if (YM_CRC_INCREMENTAL > 0)
+	uint16_t	crc;									/** Running CRC of the current packet payload **/
+#endif
+#if (YM_DIGEST > 0)
+	uint8_t		digestGiven;							/** Digests given by the sender in block 0, YM_DIGEST_* bits **/
+	ymodem_digest_e digestStatus;						/** Digests given against the file received, set at YMODEM_FILE_CB_END **/
+#endif
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+	uint32_t	crc32;									/** CRC-32 of the file data delivered so far **/
+	uint32_t	crc32Given;								/** CRC-32 given in block 0 **/
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+	ymodem_sha256_t sha256Ctx;							/** SHA-256 of the file data delivered so far **/
+	uint8_t		sha256[32];								/** SHA-256 of the file, set at YMODEM_FILE_CB_END **/
+	uint8_t		sha256Given[32];						/** SHA-256 given in block 0 **/
+#endif
 	ymodem_err_e nextStatus; 	 						/** Status to return after closing a connection **/
 	ymodem_fxn_t serialWriteFxn;						/** Function pointer to the routine to write into serial **/
+	ymodem_crc_fxn_t crcFxn;							/** CRC provider, NULL for the software kernels **/
+	void		*crcCtx;								/** Context of the CRC provider **/
 } ymodem_t;
 
+#if (YM_SENDER > 0)
+typedef struct{
+	uint8_t		packetData[YM_PACKET_MAX_OVRHD_SIZE];	/** Packet being sent, kept for retransmission **/
+	uint16_t	packetLen;								/** Bytes of packetData to send **/
+	uint16_t	dataLen;								/** File bytes carried by the current packet **/
+	uint32_t	fileSize;								/** Size of the file being sent **/
+	uint32_t	offset;									/** File bytes acknowledged by the receiver **/
+	uint8_t		seq;									/** Sequence number of the current packet **/
+	uint8_t		state;									/** Sender state **/
+	uint8_t		retries;								/** NAKs received for the current packet **/
+	uint8_t		prevC;									/** Previous byte received **/
+	uint8_t		streaming;								/** Receiver asked for YMODEM-G **/
+	uint8_t		winOffer;								/** Window offered in block 0, 0 for none **/
+	uint8_t		window;									/** Window agreed with the receiver, 0 for stop-and-wait **/
+	uint32_t	nextPkt;								/** Window mode: next new packet to send **/
+	uint32_t	ackedPkt;								/** Window mode: first packet not confirmed yet **/
+	uint8_t		extIdx;									/** Receiver's extension answer: 1 marker seen, 2 in parameters, 3 parsed, 4 damaged **/
+	uint8_t		extPend;								/** Accepted extensions whose parameter is still to be read **/
+	uint8_t		resp[3];								/** Window answer being collected: ACK or NAK, sequence, complement **/
+	uint8_t		respLen;								/** Bytes of resp[] collected **/
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+	uint16_t	largeOffer;								/** Large block size offered in block 0, 0 for none **/
+	uint16_t	largeSize;								/** Large block size agreed with the receiver **/
+#endif
+#if (YM_RESUME > 0)
+	uint8_t		resumeOffer;							/** Resume offered in block 0 **/
+	uint8_t		resumeDigits;							/** Digits of the resume offset parsed **/
+	uint32_t	resumeKb;								/** Resume offset in KB, as parsed so far **/
+#endif
+#if (YM_LZ > 0)
+	uint8_t		lzOffer;								/** LZ window bits offered in block 0, 0 for none **/
+	uint8_t		lzBits;									/** LZ window bits agreed with the receiver **/
+	uint16_t	lzHist;									/** Bytes of history at the start of lzBuf **/
+	uint16_t	lzHash[1 << YM_LZ_HASH_BITS];			/** Last position in lzBuf of each 3 byte hash **/
+	uint8_t		lzBuf[(1 << YM_LZ_WINDOW_BITS) + YM_LZ_INPUT];	/** History, then the file data being compressed **/
+#endif
+#if (YM_DIGEST > 0)
+	uint8_t		digestOffer;							/** Give the digest of the file in block 0 **/
+#endif
+	uint8_t		initialized;							/** Initialized flag **/
+	ymodem_err_e nextStatus;							/** Status to return after closing the connection **/
+	ymodem_fxn_t serialWriteFxn;						/** Function pointer to the routine to write into serial **/
+} ymodem_tx_t;
+#endif
+
 
 void 			ymodem_Init(ymodem_t *ymodem, ymodem_fxn_t SerialWriteFxn);
 ymodem_err_e 	ymodem_ReceiveByte(ymodem_t *ymodem, uint8_t byte);
+ymodem_err_e 	ymodem_ReceiveBuffer(ymodem_t *ymodem, const uint8_t *buf, size_t len, size_t *consumed);
 ymodem_err_e 	ymodem_Reset(ymodem_t *ymodem);
+ymodem_err_e 	ymodem_LineIdle(ymodem_t *ymodem);
+ymodem_err_e 	ymodem_Tick(ymodem_t *ymodem, uint32_t elapsedMs);
+void			ymodem_SetStreaming(ymodem_t *ymodem, uint8_t enable);
+#if (YM_RESUME > 0)
+uint32_t		ymodem_Resume(ymodem_t *ymodem, uint32_t committed);
+#endif
+ymodem_err_e 	ymodem_CompleteCallback(ymodem_t *ymodem, ymodem_err_e status);
+void			ymodem_SetCrcFxn(ymodem_t *ymodem, ymodem_crc_fxn_t fxn, void *ctx);
+ymodem_err_e 	ymodem_CheckCrcFxn(ymodem_t *ymodem);
+uint16_t		ymodem_Crc16(void *ctx, uint16_t crc, const uint8_t *data, uint32_t len);
+#if (YM_SENDER > 0)
+void			ymodem_TxInit(ymodem_tx_t *tx, ymodem_fxn_t SerialWriteFxn);
+ymodem_err_e 	ymodem_TxStart(ymodem_tx_t *tx, const char *fileName, uint32_t fileSize);
+ymodem_err_e 	ymodem_TxReceiveByte(ymodem_tx_t *tx, uint8_t byte);
+ymodem_err_e 	ymodem_TxPoll(ymodem_tx_t *tx);
+void			ymodem_TxSetWindow(ymodem_tx_t *tx, uint8_t window);
+#if (YM_PACKET_MAX_SIZE > YM_PACKET_1K_SIZE)
+void			ymodem_TxSetLargeBlocks(ymodem_tx_t *tx, uint16_t size);
+#endif
+#if (YM_RESUME > 0)
+void			ymodem_TxSetResume(ymodem_tx_t *tx, uint8_t enable);
+#endif
+#if (YM_LZ > 0)
+void			ymodem_TxSetCompression(ymodem_tx_t *tx, uint8_t windowBits);
+#endif
+#if (YM_DIGEST > 0)
+void			ymodem_TxSetDigest(ymodem_tx_t *tx, uint8_t enable);
+#endif
+ymodem_err_e 	ymodem_TxAbort(ymodem_tx_t *tx);
+#endif
+#if (YM_DIGEST & YM_DIGEST_CRC32)
+uint32_t		ymodem_Crc32(uint32_t crc, const uint8_t *data, uint32_t len);
+#endif
+#if (YM_DIGEST & YM_DIGEST_SHA256)
+void			ymodem_Sha256Init(ymodem_sha256_t *ctx);
+void			ymodem_Sha256Update(ymodem_sha256_t *ctx, const uint8_t *data, uint32_t len);
+void			ymodem_Sha256Final(ymodem_sha256_t *ctx, uint8_t digest[32]);
+#endif
+#if (YM_ZERO_COPY > 0)
+ymodem_err_e 	ymodem_SubmitBuffer(ymodem_t *ymodem, uint8_t *buf);
+ymodem_err_e 	ymodem_ReleaseBuffer(ymodem_t *ymodem, uint8_t *data);
+#endif
 
 /* Callback */
 /**
@@ -114,17 +471,42 @@ ymodem_err_e 	ymodem_Reset(ymodem_t *ymodem);
  * @param	e			Event to tell what operation type of data was received over the YMODEM
  * @param	data		The data contaning the arrat information. The data is dependent of the 'e' parameter:
  * 						YMODEM_FILE_CB_NAME the data is the fileName received over the protocol.
- * 						YMODEM_FILE_CB_DATA the data contains the raw data of the file.
- * 						YMODEM_FILE_CB_END data is NULL and don't care.
+ * 						With YM_RESUME, ymodem_Resume can be called here to go on from a checkpoint.
+ * 						YMODEM_FILE_CB_DATA the data contains the raw data of the file, starting at
+ * 						ymodem->fileOffset. With YM_ZERO_COPY the
+ * 						buffer holding it (YM_PACKET_BUFFER(data)) now belongs to the application, and must be
+ * 						handed back with ymodem_SubmitBuffer (or ymodem_ReleaseBuffer(data)) when it is no
+ * 						longer needed. With YM_DOUBLE_BUFFER the sender is ACKed while data is being drained.
+ * 						YMODEM_FILE_CB_END data is NULL and don't care. With YM_DIGEST the digest of the file
+ * 						is in ymodem_t, and digestStatus tells if it matches the one from block 0.
  * 						YMODEM_FILE_CB_ABORT data is NULL.
  * @param 	len			Indicate a lenth of something, but, this length, like the data, is dependent of the 'e'.
  * 						YMODEM_FILE_CB_NAME will indicate the file length.
- * 						YMODEM_FILE_CB_DATA is the amount of data.
+ * 						YMODEM_FILE_CB_DATA is the amount of data. The last packet is cut to the file size
+ * 						given in block 0, a packet holding nothing but padding is not delivered.
+ * 						With YM_LZ, a compressed packet may be delivered in several calls, which must
+ * 						return YMODEM_OK.
  * 						YMODEM_FILE_CB_END don't care.
  * 						YMODEM_FILE_CB_ABORT don't.
  *
  * @ret		Return the operation status. This is very important to generate correct
+ * 			For YMODEM_FILE_CB_NAME and YMODEM_FILE_CB_DATA, YMODEM_PENDING means the operation goes on
+ * 			asynchronously: the response is held (and input ignored) until ymodem_CompleteCallback.
  */
 ymodem_err_e	ymodem_FileCallback(ymodem_t *ymodem, ymodem_file_cb_e e, uint8_t *data, uint32_t len);
 
+#if (YM_SENDER > 0)
+/**
+ * @brief 	Callback to read the file being sent. Same caution as ymodem_FileCallback, it is called from
+ * 			ymodem_TxReceiveByte. A packet is read once, retransmissions reuse the copy inside ymodem_tx_t.
+ * @param	tx			The handler of the YMODEM sender
+ * @param	offset		Position in the file of the first byte to read
+ * @param	data		Where to copy the file data
+ * @param	len			Number of bytes to read, never past the size given to ymodem_TxStart
+ *
+ * @ret		Number of bytes copied. Anything other than len cancels the transfer.
+ */
+uint32_t		ymodem_TxReadCallback(ymodem_tx_t *tx, uint32_t offset, uint8_t *data, uint32_t len);
+#endif
+
 #endif // YMODEM_H
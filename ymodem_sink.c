@@ -0,0 +1,751 @@
+/**
+ * @file   ymodem_sink.c
+ * @brief  Flash sink for the YMODEM receiver. The data of YMODEM_FILE_CB_DATA comes in 128 byte
+ *         to 8K pieces, flash is programmed best in whole aligned pages: the pieces are collected
+ *         in a page buffer, sectors are erased as the file reaches them, and every page is
+ *         programmed once.
+ */
+#include "ymodem_sink.h"
+
+static ymodem_err_e ymodem_SinkWrite(ymodem_sink_t *sink, uint32_t addr, const uint8_t *data, uint32_t len);
+static ymodem_err_e ymodem_SinkProgramPage(ymodem_sink_t *sink);
+static ymodem_err_e ymodem_SinkEraseTo(ymodem_sink_t *sink, uint32_t addr);
+static void			ymodem_SinkWait(ymodem_sink_t *sink, uint32_t addr);
+static ymodem_err_e ymodem_SinkWriteSector(ymodem_sink_t *sink, uint32_t addr, const uint8_t *data, uint32_t len);
+static ymodem_err_e ymodem_SinkCommitSector(ymodem_sink_t *sink);
+static uint8_t		ymodem_SinkErased(const uint8_t *data, uint32_t len);
+
+
+/**
+ * @brief  				Initialise a sink. The file is written from flash address 0 with no room
+ * 						until ymodem_SinkSetRegion.
+ *
+ * @param  sink			Sink instance.
+ * @param  ops			Flash operations, copied
+ * @param  page			Page buffer of pageSize bytes
+ * @param  pageSize		Program unit, a power of 2
+ * @param  sectorSize	Erase unit, a multiple of pageSize
+ */
+void ymodem_SinkInit(ymodem_sink_t *sink, const ymodem_sink_ops_t *ops, uint8_t *page, uint32_t pageSize, uint32_t sectorSize) {
+	assert (sink != NULL);
+	assert ((ops != NULL) && (ops->erase != NULL) && (ops->program != NULL));
+	assert (page != NULL);
+	assert ((pageSize > 0) && ((pageSize & (pageSize - 1)) == 0));
+	assert ((sectorSize >= pageSize) && ((sectorSize % pageSize) == 0));
+
+	sink->ops			= *ops;
+	sink->page			= page;
+	sink->pageSize		= pageSize;
+	sink->sectorSize	= sectorSize;
+	sink->base			= 0;
+	sink->capacity		= 0;
+	sink->keepOnAbort	= 0;
+	sink->fresh			= 1;
+	sink->pageAddr		= 0;
+	sink->pageLo		= 0;
+	sink->pageHi		= 0;
+	sink->eraseFrom		= 0;
+	sink->erasedTo		= 0;
+	sink->eraseEnd		= 0;
+	sink->erasing		= 0;
+	sink->sector		= NULL;
+	sink->secAddr		= 0;
+	sink->secHi			= 0;
+	sink->comparedSectors	= 0;
+	sink->skippedSectors	= 0;
+	sink->committed		= 0;
+	sink->skipTo		= 0;
+	sink->eraseOps		= 0;
+	sink->programOps	= 0;
+}
+
+/**
+ * @brief  				Sets where the files go. Each file is written from base, a file bigger than
+ * 						capacity is refused in YMODEM_FILE_CB_NAME. Call it again from the application's
+ * 						callback, before passing YMODEM_FILE_CB_NAME on, to put files of a batch elsewhere.
+ *
+ * @param  sink			Sink instance.
+ * @param  base			Flash address, sector aligned
+ * @param  capacity		Bytes of flash from base
+ */
+void ymodem_SinkSetRegion(ymodem_sink_t *sink, uint32_t base, uint32_t capacity) {
+	assert (sink != NULL);
+	assert ((base % sink->sectorSize) == 0);
+
+	sink->base = base;
+	sink->capacity = capacity;
+}
+
+/**
+ * @brief  				Keeps what was programmed when the transfer is aborted, so it can be resumed
+ * 						from committed. Otherwise the sectors written are erased again.
+ *
+ * @param  sink			Sink instance.
+ * @param  enable		1 to keep, 0 to erase
+ */
+void ymodem_SinkSetKeepOnAbort(ymodem_sink_t *sink, uint8_t enable) {
+	assert (sink != NULL);
+
+	sink->keepOnAbort = (enable != 0);
+}
+
+/**
+ * @brief  				Compare-before-write, for an update that changes little of the image in flash.
+ * 						Data is collected a whole sector at a time, then compared with the flash (read
+ * 						back through ops.read). A sector that holds the same bytes already is neither
+ * 						erased nor programmed, and counted in skippedSectors. Otherwise it is erased and
+ * 						its pages programmed, but for pages left erased. Erase-ahead is off meanwhile,
+ * 						as it would erase what is compared. An abort only erases again from the first to
+ * 						the last sector rewritten, an image that matches is left as it was.
+ *
+ * @param  sink			Sink instance.
+ * @param  sector		Sector buffer of sectorSize bytes, NULL to turn it off
+ */
+void ymodem_SinkSetCompare(ymodem_sink_t *sink, uint8_t *sector) {
+	assert (sink != NULL);
+	assert ((sector == NULL) || (sink->ops.read != NULL));
+
+	sink->sector = sector;
+	sink->secHi = 0;
+}
+
+/**
+ * @brief  				Handles a file event, to be called from ymodem_FileCallback with its arguments.
+ * 						Data is buffered into pages by its offset in the file (ymodem->fileOffset), sectors
+ * 						are erased as the pages reach them. At YMODEM_FILE_CB_END the last page is padded
+ * 						and programmed, and the flash flushed. With YM_ZERO_COPY the packet buffer is given
+ * 						back to the library, the data is copied.
+ *
+ * @param  sink			Sink instance.
+ * @param  ymodem		Ymodem instance.
+ * @param  e			Event
+ * @param  data			As ymodem_FileCallback
+ * @param  len			As ymodem_FileCallback
+ * @return YMODEM_T 	YMODEM_OK, YMODEM_SIZE_ERR for a file bigger than the region, YMODEM_WRITE_ERR if
+ * 						a flash operation failed
+ */
+ymodem_err_e ymodem_SinkCallback(ymodem_sink_t *sink, ymodem_t *ymodem, ymodem_file_cb_e e, uint8_t *data, uint32_t len) {
+	ymodem_err_e ret = YMODEM_OK;
+	uint32_t offset, skip = 0;
+
+	assert (sink != NULL);
+	assert (ymodem != NULL);
+
+	switch (e) {
+		case YMODEM_FILE_CB_NAME:
+			if (ymodem->fileSizeKnown && (len > sink->capacity)) {
+				ret = YMODEM_SIZE_ERR;
+				break;
+			}
+			sink->fresh = 1;
+			sink->pageHi = 0;
+			sink->secHi = 0;
+			sink->committed = 0;
+			sink->skipTo = 0;
+			ymodem_SinkWait(sink, sink->erasedTo);
+			sink->erasing = 0;
+			sink->eraseFrom = sink->base;
+			sink->erasedTo = sink->base;
+			/* The sectors of the file are known before its first byte */
+			sink->eraseEnd = 0;
+			if (ymodem->fileSizeKnown) {
+				sink->eraseEnd = sink->base + len + (sink->sectorSize - 1) - ((len + (sink->sectorSize - 1)) % sink->sectorSize);
+			}
+			if (sink->keepOnAbort == 0) {
+				/* Nothing to resume, the first erase can use the gap before the first packet */
+				ret = ymodem_SinkPoll(sink);
+			}
+			break;
+		case YMODEM_FILE_CB_DATA:
+			offset = ymodem->fileOffset;
+			if (offset < sink->skipTo) {
+				/* Sent again from the 1K boundary before the checkpoint, already programmed */
+				skip = (len < sink->skipTo - offset) ? len : sink->skipTo - offset;
+				offset += skip;
+				len -= skip;
+			}
+			if ((offset > sink->capacity) || (len > sink->capacity - offset)) {
+				ret = YMODEM_WRITE_ERR;
+			} else if (len > 0) {
+				ret = ymodem_SinkWrite(sink, sink->base + offset, data + skip, len);
+			}
+			if (ret == YMODEM_OK) {
+				/* The next packet takes a while on the line, erase meanwhile */
+				ret = ymodem_SinkPoll(sink);
+			}
+#if (YM_ZERO_COPY > 0)
+			ymodem_ReleaseBuffer(ymodem, data);
+#endif
+			break;
+		case YMODEM_FILE_CB_END:
+			if (sink->pageHi > 0) {
+				ret = ymodem_SinkProgramPage(sink);
+			}
+			if ((ret == YMODEM_OK) && (sink->secHi > 0)) {
+				ret = ymodem_SinkCommitSector(sink);
+			}
+			if (sink->erasing) {
+				ymodem_SinkWait(sink, sink->erasedTo);
+				sink->erasing = 0;
+				sink->erasedTo += sink->sectorSize;
+			}
+			if ((ret == YMODEM_OK) && (sink->ops.flush != NULL)) {
+				ret = sink->ops.flush(sink->ops.ctx);
+			}
+			/* Written, nothing to roll back or erase any more */
+			sink->eraseFrom = sink->erasedTo;
+			sink->eraseEnd = 0;
+			sink->fresh = 1;
+			break;
+		case YMODEM_FILE_CB_ABORTED:
+			ret = ymodem_SinkAbort(sink);
+			break;
+		default:
+			break;
+	}
+	return ret;
+}
+
+#if (YM_RESUME > 0)
+/**
+ * @brief  				Resumes the file from what an earlier, aborted transfer kept in flash (see
+ * 						ymodem_SinkSetKeepOnAbort), to be called at YMODEM_FILE_CB_NAME after
+ * 						ymodem_SinkCallback. The sender goes back to a 1K boundary, the bytes re-sent
+ * 						before committed are not programmed twice.
+ *
+ * @param  sink			Sink instance.
+ * @param  ymodem		Ymodem instance.
+ * @param  committed	sink->committed saved from the earlier transfer
+ * @return uint32_t 	As ymodem_Resume. At 0 the whole file is sent and written again.
+ */
+uint32_t ymodem_SinkResume(ymodem_sink_t *sink, ymodem_t *ymodem, uint32_t committed) {
+	uint32_t offset;
+
+	assert (sink != NULL);
+
+	assert (sink->erasing == 0);
+
+	offset = ymodem_Resume(ymodem, committed);
+	if (offset > 0) {
+		sink->skipTo = committed;
+		sink->committed = committed;
+		committed += sink->base;
+		sink->eraseFrom = committed + (sink->sectorSize - 1) - ((committed + (sink->sectorSize - 1)) % sink->sectorSize);
+		sink->erasedTo = sink->eraseFrom;
+	}
+	return offset;
+}
+#endif
+
+/**
+ * @brief  				Erase-ahead scheduler, for flash whose erase runs in the background (ops.busy set).
+ * 						An erase takes 20 to 500 ms on NOR flash, longer than a packet on the line: done
+ * 						when a page needs it, it holds up the ACK. Instead the sectors of the file, known
+ * 						from its size in block 0, are erased up to YM_SINK_ERASE_AHEAD sectors ahead of
+ * 						the data, one at a time, while the packets are on the line. The sink calls it
+ * 						after YMODEM_FILE_CB_NAME and after each YMODEM_FILE_CB_DATA; call it from the
+ * 						main loop as well, e.g. next to ymodem_Tick, to start the next erase sooner.
+ *
+ * @param  sink			Sink instance.
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_WRITE_ERR if an erase failed to start
+ */
+ymodem_err_e ymodem_SinkPoll(ymodem_sink_t *sink) {
+	uint32_t cursor;
+
+	assert (sink != NULL);
+
+	if ((sink->ops.busy == NULL) || (sink->sector != NULL)) {
+		return YMODEM_OK;
+	}
+	if (sink->erasing) {
+		if (sink->ops.busy(sink->ops.ctx, sink->erasedTo)) {
+			return YMODEM_OK;
+		}
+		sink->erasing = 0;
+		sink->erasedTo += sink->sectorSize;
+	}
+	/* Sector being written, the next one once the page buffered is full */
+	cursor = sink->base + sink->committed;
+	if (sink->pageHi > 0) {
+		cursor = sink->pageAddr + sink->pageHi;
+	}
+	if (cursor < sink->eraseFrom) {
+		cursor = sink->eraseFrom;
+	}
+	cursor -= cursor % sink->sectorSize;
+	if ((sink->erasedTo < sink->eraseEnd) && (sink->erasedTo < cursor + (YM_SINK_ERASE_AHEAD + 1) * sink->sectorSize)) {
+		sink->eraseOps++;
+		if (sink->ops.erase(sink->ops.ctx, sink->erasedTo, sink->sectorSize) != YMODEM_OK) {
+			return YMODEM_WRITE_ERR;
+		}
+		sink->erasing = 1;
+	}
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Drops the page being collected and, unless kept for a resume, erases again the
+ * 						sectors the current file has written, so no half image is left. The library only
+ * 						reports a cancel from the sender with YMODEM_FILE_CB_ABORTED: call it as well when
+ * 						ymodem_ReceiveByte, ymodem_Tick or ymodem_CompleteCallback end the transfer with
+ * 						an error.
+ *
+ * @param  sink			Sink instance.
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_WRITE_ERR if an erase failed
+ */
+ymodem_err_e ymodem_SinkAbort(ymodem_sink_t *sink) {
+	ymodem_err_e ret = YMODEM_OK;
+	uint32_t addr;
+
+	assert (sink != NULL);
+
+	sink->pageHi = 0;
+	sink->secHi = 0;
+	if (sink->erasing) {
+		ymodem_SinkWait(sink, sink->erasedTo);
+		sink->erasing = 0;
+		sink->erasedTo += sink->sectorSize;
+	}
+	if (sink->keepOnAbort == 0) {
+		for (addr = sink->eraseFrom; addr < sink->erasedTo; addr += sink->sectorSize) {
+			if (sink->ops.erase(sink->ops.ctx, addr, sink->sectorSize) != YMODEM_OK) {
+				ret = YMODEM_WRITE_ERR;
+			}
+			sink->eraseOps++;
+			ymodem_SinkWait(sink, addr);
+		}
+		/* Only a resumed part before the first sector erased is left */
+		if (sink->committed > sink->eraseFrom - sink->base) {
+			sink->committed = sink->eraseFrom - sink->base;
+		}
+		sink->erasedTo = sink->eraseFrom;
+	}
+	sink->eraseEnd = 0;
+	sink->fresh = 1;
+	return ret;
+}
+
+/**
+ * @brief  				Copies file data into the page buffer, programming each page once it is full.
+ *
+ * @param  sink			Sink instance.
+ * @param  addr			Flash address of the data
+ * @param  data			File data
+ * @param  len			Bytes of data
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_WRITE_ERR
+ */
+static ymodem_err_e ymodem_SinkWrite(ymodem_sink_t *sink, uint32_t addr, const uint8_t *data, uint32_t len) {
+	ymodem_err_e ret;
+	uint32_t n;
+
+	if (sink->sector != NULL) {
+		if (sink->fresh) {
+			/* The sector of the first byte is read back, merged and written again as a whole */
+			sink->eraseFrom = addr - (addr % sink->sectorSize);
+			sink->erasedTo = sink->eraseFrom;
+			sink->fresh = 0;
+		}
+		return ymodem_SinkWriteSector(sink, addr, data, len);
+	}
+	if (sink->fresh) {
+		/* First data of the file. When it resumes inside a sector, that sector was erased by
+		 * the interrupted transfer, erasing starts at the next one */
+		if ((sink->erasedTo == sink->eraseFrom) && (sink->erasing == 0)) {
+			sink->eraseFrom = addr + (sink->sectorSize - 1) - ((addr + (sink->sectorSize - 1)) % sink->sectorSize);
+			sink->erasedTo = sink->eraseFrom;
+		}
+		sink->fresh = 0;
+	}
+	while (len > 0) {
+		if ((sink->pageHi > 0) && (addr != sink->pageAddr + sink->pageHi)) {
+			/* Not where the page left off, program what it holds */
+			if ((ret = ymodem_SinkProgramPage(sink)) != YMODEM_OK) {
+				return ret;
+			}
+		}
+		if (sink->pageHi == 0) {
+			sink->pageAddr = addr & ~(sink->pageSize - 1);
+			sink->pageLo = addr - sink->pageAddr;
+			sink->pageHi = sink->pageLo;
+			memset(sink->page, YM_SINK_ERASED, sink->pageLo);
+		}
+		n = sink->pageSize - sink->pageHi;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(sink->page + sink->pageHi, data, n);
+		sink->pageHi += n;
+		addr += n;
+		data += n;
+		len -= n;
+		if (sink->pageHi == sink->pageSize) {
+			if ((ret = ymodem_SinkProgramPage(sink)) != YMODEM_OK) {
+				return ret;
+			}
+		}
+	}
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Copies file data into the sector buffer, for compare-before-write. The flash before
+ * 						the data in its sector, e.g. when resumed, is read back into the buffer first.
+ *
+ * @param  sink			Sink instance.
+ * @param  addr			Flash address of the data
+ * @param  data			File data
+ * @param  len			Bytes of data
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_WRITE_ERR
+ */
+static ymodem_err_e ymodem_SinkWriteSector(ymodem_sink_t *sink, uint32_t addr, const uint8_t *data, uint32_t len) {
+	ymodem_err_e ret;
+	uint32_t n;
+
+	while (len > 0) {
+		if ((sink->secHi > 0) && (addr != sink->secAddr + sink->secHi)) {
+			if ((ret = ymodem_SinkCommitSector(sink)) != YMODEM_OK) {
+				return ret;
+			}
+		}
+		if (sink->secHi == 0) {
+			sink->secAddr = addr - (addr % sink->sectorSize);
+			sink->secHi = addr - sink->secAddr;
+			if ((sink->secHi > 0) && (sink->ops.read(sink->ops.ctx, sink->secAddr, sink->sector, sink->secHi) != YMODEM_OK)) {
+				sink->secHi = 0;
+				return YMODEM_WRITE_ERR;
+			}
+		}
+		n = sink->sectorSize - sink->secHi;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(sink->sector + sink->secHi, data, n);
+		sink->secHi += n;
+		addr += n;
+		data += n;
+		len -= n;
+		if (sink->secHi == sink->sectorSize) {
+			if ((ret = ymodem_SinkCommitSector(sink)) != YMODEM_OK) {
+				return ret;
+			}
+		}
+	}
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Writes the sector buffered, padded to its end, unless the flash holds it already.
+ *
+ * @param  sink			Sink instance.
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_WRITE_ERR
+ */
+static ymodem_err_e ymodem_SinkCommitSector(ymodem_sink_t *sink) {
+	uint32_t off;
+	uint8_t same = 1;
+
+	memset(sink->sector + sink->secHi, YM_SINK_ERASED, sink->sectorSize - sink->secHi);
+	/* The page buffer is free in this mode, the flash is read back through it */
+	for (off = 0; (off < sink->sectorSize) && same; off += sink->pageSize) {
+		if (sink->ops.read(sink->ops.ctx, sink->secAddr + off, sink->page, sink->pageSize) != YMODEM_OK) {
+			return YMODEM_WRITE_ERR;
+		}
+		same = (memcmp(sink->page, sink->sector + off, sink->pageSize) == 0);
+	}
+	sink->comparedSectors++;
+	if (same) {
+		sink->skippedSectors++;
+	} else {
+		/* The rollback range runs from the first sector rewritten, a matching one is left alone */
+		if (sink->erasedTo == sink->eraseFrom) {
+			sink->eraseFrom = sink->secAddr;
+			sink->erasedTo = sink->secAddr;
+		}
+		sink->eraseOps++;
+		if (sink->ops.erase(sink->ops.ctx, sink->secAddr, sink->sectorSize) != YMODEM_OK) {
+			return YMODEM_WRITE_ERR;
+		}
+		ymodem_SinkWait(sink, sink->secAddr);
+		for (off = 0; off < sink->sectorSize; off += sink->pageSize) {
+			if (ymodem_SinkErased(sink->sector + off, sink->pageSize)) {
+				continue;
+			}
+			sink->programOps++;
+			if (sink->ops.program(sink->ops.ctx, sink->secAddr + off, sink->sector + off, sink->pageSize) != YMODEM_OK) {
+				return YMODEM_WRITE_ERR;
+			}
+		}
+		if (sink->erasedTo < sink->secAddr + sink->sectorSize) {
+			sink->erasedTo = sink->secAddr + sink->sectorSize;
+		}
+	}
+	sink->committed = sink->secAddr + sink->secHi - sink->base;
+	sink->secHi = 0;
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Tells if a page is all erased bytes, word by word.
+ *
+ * @param  data			Page
+ * @param  len			Bytes, a multiple of 4
+ * @return uint8_t 		1 if erased
+ */
+static uint8_t ymodem_SinkErased(const uint8_t *data, uint32_t len) {
+	uint32_t word;
+	uint32_t i;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		memcpy(&word, data + i, 4);
+		if (word != (uint32_t)(YM_SINK_ERASED * 0x01010101UL)) {
+			return 0;
+		}
+	}
+	for (; i < len; i++) {
+		if (data[i] != YM_SINK_ERASED) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief  				Programs the page buffered, padded to its end, after erasing its sector if needed.
+ *
+ * @param  sink			Sink instance.
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_WRITE_ERR
+ */
+static ymodem_err_e ymodem_SinkProgramPage(ymodem_sink_t *sink) {
+	ymodem_err_e ret;
+
+	if ((ret = ymodem_SinkEraseTo(sink, sink->pageAddr + sink->pageSize)) != YMODEM_OK) {
+		return ret;
+	}
+	if (sink->erasing) {
+		/* An erase ahead runs, the flash may not take a program until it is done */
+		ymodem_SinkWait(sink, sink->pageAddr);
+	}
+	memset(sink->page + sink->pageHi, YM_SINK_ERASED, sink->pageSize - sink->pageHi);
+	ret = sink->ops.program(sink->ops.ctx, sink->pageAddr + sink->pageLo, sink->page + sink->pageLo, sink->pageSize - sink->pageLo);
+	sink->programOps++;
+	if (ret != YMODEM_OK) {
+		return YMODEM_WRITE_ERR;
+	}
+	sink->committed = sink->pageAddr + sink->pageHi - sink->base;
+	sink->pageHi = 0;
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Erases the sectors up to addr that the current file has not erased yet.
+ *
+ * @param  sink			Sink instance.
+ * @param  addr			End of the flash about to be programmed
+ * @return YMODEM_T 	YMODEM_OK, or YMODEM_WRITE_ERR
+ */
+static ymodem_err_e ymodem_SinkEraseTo(ymodem_sink_t *sink, uint32_t addr) {
+	while (sink->erasedTo < addr) {
+		if (sink->erasing == 0) {
+			sink->eraseOps++;
+			if (sink->ops.erase(sink->ops.ctx, sink->erasedTo, sink->sectorSize) != YMODEM_OK) {
+				return YMODEM_WRITE_ERR;
+			}
+		}
+		/* Not erased ahead in time, this is the stall the scheduler is there to avoid */
+		ymodem_SinkWait(sink, sink->erasedTo);
+		sink->erasing = 0;
+		sink->erasedTo += sink->sectorSize;
+	}
+	return YMODEM_OK;
+}
+
+/**
+ * @brief  				Waits until addr can be programmed, with an erase running in the background.
+ *
+ * @param  sink			Sink instance.
+ * @param  addr			Flash address
+ */
+static void ymodem_SinkWait(ymodem_sink_t *sink, uint32_t addr) {
+	if (sink->ops.busy != NULL) {
+		while (sink->ops.busy(sink->ops.ctx, addr)) {
+		}
+	}
+}
+
+#if (YM_SINK_SIM > 0)
+static ymodem_err_e ymodem_FlashSimErase(void *ctx, uint32_t addr, uint32_t len);
+static ymodem_err_e ymodem_FlashSimProgram(void *ctx, uint32_t addr, const uint8_t *data, uint32_t len);
+static ymodem_err_e ymodem_FlashSimFlush(void *ctx);
+static uint8_t		ymodem_FlashSimBusy(void *ctx, uint32_t addr);
+static ymodem_err_e ymodem_FlashSimRead(void *ctx, uint32_t addr, uint8_t *data, uint32_t len);
+
+/**
+ * @brief  				Initialise a simulated flash over mem, erased. It counts the operations and
+ * 						checks them like a flash with ECC would: erases of whole sectors, programs inside
+ * 						one page, and only over erased bytes. The operations take no time until
+ * 						ymodem_FlashSimSetTiming.
+ *
+ * @param  sim			Simulated flash instance.
+ * @param  mem			Flash contents, size bytes
+ * @param  base			Flash address of mem[0], sector aligned
+ * @param  size			Bytes of flash
+ * @param  pageSize		Program unit
+ * @param  sectorSize	Erase unit
+ */
+void ymodem_FlashSimInit(ymodem_flashsim_t *sim, uint8_t *mem, uint32_t base, uint32_t size, uint32_t pageSize, uint32_t sectorSize) {
+	assert (sim != NULL);
+	assert (mem != NULL);
+
+	memset(mem, YM_SINK_ERASED, size);
+	sim->mem			= mem;
+	sim->base			= base;
+	sim->size			= size;
+	sim->pageSize		= pageSize;
+	sim->sectorSize		= sectorSize;
+	sim->eraseOps		= 0;
+	sim->programOps		= 0;
+	sim->programBytes	= 0;
+	sim->flushOps		= 0;
+	sim->readBytes		= 0;
+	sim->errors			= 0;
+	sim->nowUs			= 0;
+	sim->eraseUs		= 0;
+	sim->programUs		= 0;
+	sim->pollUs			= 10;
+	sim->background		= 0;
+	sim->concurrent		= 0;
+	sim->busyUntilUs	= 0;
+	sim->busyAddr		= 0;
+	sim->busyLen		= 0;
+	sim->eraseWaitUs	= 0;
+	sim->programTimeUs	= 0;
+}
+
+/**
+ * @brief  				Gives the simulated flash a clock. Each operation moves nowUs on by the time it
+ * 						takes the CPU: a program programUs, an erase eraseUs per sector, or nothing when
+ * 						it runs in the background, and each busy check pollUs (a status register read).
+ * 						The test moves nowUs on with the line time in between.
+ *
+ * @param  sim			Simulated flash instance.
+ * @param  eraseUs		Time to erase a sector
+ * @param  programUs	Time to program a page
+ * @param  background	1 for erases in the background, checked with ops.busy
+ * @param  concurrent	1 if pages outside the sector being erased can be programmed meanwhile
+ * 						(dual bank, or erase suspend)
+ */
+void ymodem_FlashSimSetTiming(ymodem_flashsim_t *sim, uint32_t eraseUs, uint32_t programUs, uint8_t background, uint8_t concurrent) {
+	assert (sim != NULL);
+
+	sim->eraseUs = eraseUs;
+	sim->programUs = programUs;
+	sim->background = (background != 0);
+	sim->concurrent = (concurrent != 0);
+}
+
+/**
+ * @brief  				Fills in the flash operations of a sink with the simulated flash.
+ *
+ * @param  sim			Simulated flash instance.
+ * @param  ops			Operations to fill in, for ymodem_SinkInit
+ */
+void ymodem_FlashSimOps(ymodem_flashsim_t *sim, ymodem_sink_ops_t *ops) {
+	assert (ops != NULL);
+
+	ops->erase		= ymodem_FlashSimErase;
+	ops->program	= ymodem_FlashSimProgram;
+	ops->flush		= ymodem_FlashSimFlush;
+	ops->busy		= sim->background ? ymodem_FlashSimBusy : NULL;
+	ops->read		= ymodem_FlashSimRead;
+	ops->ctx		= sim;
+}
+
+static ymodem_err_e ymodem_FlashSimErase(void *ctx, uint32_t addr, uint32_t len) {
+	ymodem_flashsim_t *sim = (ymodem_flashsim_t *)ctx;
+
+	if ((addr < sim->base) || (addr - sim->base > sim->size) || (len > sim->size - (addr - sim->base)) ||
+			(((addr - sim->base) % sim->sectorSize) != 0) || ((len % sim->sectorSize) != 0)) {
+		sim->errors++;
+		return YMODEM_WRITE_ERR;
+	}
+	if (sim->nowUs < sim->busyUntilUs) {
+		/* Still erasing */
+		sim->errors++;
+		return YMODEM_WRITE_ERR;
+	}
+	memset(sim->mem + (addr - sim->base), YM_SINK_ERASED, len);
+	sim->eraseOps += len / sim->sectorSize;
+	if (sim->background) {
+		sim->busyUntilUs = sim->nowUs + sim->eraseUs * (len / sim->sectorSize);
+		sim->busyAddr = addr;
+		sim->busyLen = len;
+	} else {
+		sim->nowUs += sim->eraseUs * (len / sim->sectorSize);
+		sim->eraseWaitUs += sim->eraseUs * (len / sim->sectorSize);
+	}
+	return YMODEM_OK;
+}
+
+static ymodem_err_e ymodem_FlashSimProgram(void *ctx, uint32_t addr, const uint8_t *data, uint32_t len) {
+	ymodem_flashsim_t *sim = (ymodem_flashsim_t *)ctx;
+	uint8_t *dst;
+	uint32_t i;
+
+	if ((addr < sim->base) || (addr - sim->base > sim->size) || (len > sim->size - (addr - sim->base)) ||
+			(((addr - sim->base) % sim->pageSize) + len > sim->pageSize)) {
+		sim->errors++;
+		return YMODEM_WRITE_ERR;
+	}
+	if (ymodem_FlashSimBusy(sim, addr) || ymodem_FlashSimBusy(sim, addr + len - 1)) {
+		/* Programmed during an erase, without waiting for it */
+		sim->errors++;
+		return YMODEM_WRITE_ERR;
+	}
+	dst = sim->mem + (addr - sim->base);
+	for (i = 0; i < len; i++) {
+		if (dst[i] != YM_SINK_ERASED) {
+			/* Programmed twice without an erase */
+			sim->errors++;
+			return YMODEM_WRITE_ERR;
+		}
+	}
+	memcpy(dst, data, len);
+	sim->programOps++;
+	sim->programBytes += len;
+	sim->nowUs += sim->programUs;
+	sim->programTimeUs += sim->programUs;
+	return YMODEM_OK;
+}
+
+static ymodem_err_e ymodem_FlashSimFlush(void *ctx) {
+	ymodem_flashsim_t *sim = (ymodem_flashsim_t *)ctx;
+
+	sim->flushOps++;
+	return YMODEM_OK;
+}
+
+static ymodem_err_e ymodem_FlashSimRead(void *ctx, uint32_t addr, uint8_t *data, uint32_t len) {
+	ymodem_flashsim_t *sim = (ymodem_flashsim_t *)ctx;
+
+	if ((addr < sim->base) || (addr - sim->base > sim->size) || (len > sim->size - (addr - sim->base))) {
+		sim->errors++;
+		return YMODEM_WRITE_ERR;
+	}
+	memcpy(data, sim->mem + (addr - sim->base), len);
+	sim->readBytes += len;
+	return YMODEM_OK;
+}
+
+static uint8_t ymodem_FlashSimBusy(void *ctx, uint32_t addr) {
+	ymodem_flashsim_t *sim = (ymodem_flashsim_t *)ctx;
+
+	if (sim->nowUs >= sim->busyUntilUs) {
+		return 0;
+	}
+	if (sim->concurrent && ((addr < sim->busyAddr) || (addr - sim->busyAddr >= sim->busyLen))) {
+		return 0;
+	}
+	sim->nowUs += sim->pollUs;
+	sim->eraseWaitUs += sim->pollUs;
+	return 1;
+}
+#endif
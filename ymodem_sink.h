@@ -0,0 +1,132 @@
+/**
+ * @file   ymodem_sink.h
+ * @brief  Flash sink for the YMODEM receiver: collects the data of YMODEM_FILE_CB_DATA into
+ *         aligned pages and erases/programs them through the application's flash operations
+ */
+#ifndef YMODEM_SINK_H_
+#define YMODEM_SINK_H_
+
+/*
+ * Includes
+ */
+
+#include "ymodem.h"
+
+/*
+ * Macros
+ */
+
+/** Value of an erased flash byte, used to pad the pages **/
+#ifndef YM_SINK_ERASED
+#define YM_SINK_ERASED				(0xFF)
+#endif
+
+/** Sectors erased ahead of the data with a background erase (ops.busy), see ymodem_SinkPoll **/
+#ifndef YM_SINK_ERASE_AHEAD
+#define YM_SINK_ERASE_AHEAD			(1)
+#endif
+
+/** Set to 1 to build the simulated flash (ymodem_flashsim_t), for host tests **/
+#ifndef YM_SINK_SIM
+#define YM_SINK_SIM					(0)
+#endif
+
+/*
+ * Typedefs
+ */
+
+/**
+ * @brief  Flash operations of the target. Each returns YMODEM_OK, anything else is a write error.
+ * 			erase		Erases len bytes (whole sectors) at addr. With busy, only starts the erase.
+ * 			program		Programs len bytes at addr, already erased. Always up to the end of a page:
+ * 						a whole aligned page, or its end for the first page of a resumed file.
+ * 			flush		Optional (NULL), called once the last page of a file is programmed.
+ * 			busy		Optional (NULL), nonzero while an erase started runs and addr can not be
+ * 						programmed yet. Enables erasing ahead of the data (ymodem_SinkPoll).
+ * 			read		Optional (NULL), reads len bytes at addr. Needed by ymodem_SinkSetCompare.
+ */
+typedef struct{
+	ymodem_err_e (*erase)(void *ctx, uint32_t addr, uint32_t len);
+	ymodem_err_e (*program)(void *ctx, uint32_t addr, const uint8_t *data, uint32_t len);
+	ymodem_err_e (*flush)(void *ctx);
+	uint8_t		(*busy)(void *ctx, uint32_t addr);
+	ymodem_err_e (*read)(void *ctx, uint32_t addr, uint8_t *data, uint32_t len);
+	void		*ctx;										/** Handed to every operation **/
+} ymodem_sink_ops_t;
+
+/*
+ * structs
+ */
+
+typedef struct{
+	ymodem_sink_ops_t ops;									/** Flash operations **/
+	uint8_t		*page;										/** Page buffer, pageSize bytes **/
+	uint32_t	pageSize;									/** Program unit, a power of 2 **/
+	uint32_t	sectorSize;									/** Erase unit, a multiple of pageSize **/
+	uint32_t	base;										/** Flash address of the first byte of the file, sector aligned **/
+	uint32_t	capacity;									/** Bytes of flash from base **/
+	uint8_t		keepOnAbort;								/** Keep what was programmed when aborted, to resume later **/
+	uint8_t		fresh;										/** No data of the current file yet **/
+	uint32_t	pageAddr;									/** Flash address of the page buffered **/
+	uint32_t	pageLo;										/** First byte of the page that belongs to the file **/
+	uint32_t	pageHi;										/** End of the bytes buffered, 0 when no page is open **/
+	uint32_t	eraseFrom;									/** First sector erased for the current file, rewritten with compare **/
+	uint32_t	erasedTo;									/** Flash erased from eraseFrom up to here **/
+	uint32_t	eraseEnd;									/** End of the sectors of the file, from its size, 0 if unknown **/
+	uint8_t		erasing;									/** Erase of the sector at erasedTo running in the background **/
+	uint8_t		*sector;									/** Sector buffer for compare-before-write, NULL when off **/
+	uint32_t	secAddr;									/** Flash address of the sector buffered **/
+	uint32_t	secHi;										/** End of the bytes buffered, 0 when no sector is open **/
+	uint32_t	comparedSectors;							/** Sectors compared with the flash **/
+	uint32_t	skippedSectors;								/** Of those, the ones the flash held already **/
+	uint32_t	committed;									/** File bytes programmed, a checkpoint for ymodem_SinkResume **/
+	uint32_t	skipTo;										/** File bytes in flash from an earlier transfer, not programmed again **/
+	uint32_t	eraseOps;									/** Sectors erased **/
+	uint32_t	programOps;									/** Program operations **/
+} ymodem_sink_t;
+
+#if (YM_SINK_SIM > 0)
+typedef struct{
+	uint8_t		*mem;										/** Flash contents **/
+	uint32_t	base;										/** Flash address of mem[0] **/
+	uint32_t	size;										/** Bytes of mem **/
+	uint32_t	pageSize;									/** Program unit **/
+	uint32_t	sectorSize;									/** Erase unit **/
+	uint32_t	eraseOps;									/** Sectors erased **/
+	uint32_t	programOps;									/** Program operations **/
+	uint32_t	programBytes;								/** Bytes programmed **/
+	uint32_t	flushOps;									/** Flush operations **/
+	uint32_t	readBytes;									/** Bytes read back **/
+	uint32_t	errors;										/** Operations out of range, unaligned, programming unerased bytes or during an erase **/
+	uint32_t	nowUs;										/** Clock, moved on by the operations and by the test **/
+	uint32_t	eraseUs;									/** Time to erase a sector **/
+	uint32_t	programUs;									/** Time to program a page **/
+	uint32_t	pollUs;										/** Time of a busy check, 10 by default **/
+	uint8_t		background;									/** Erases run in the background, ops.busy is set **/
+	uint8_t		concurrent;									/** Other sectors can be programmed during an erase **/
+	uint32_t	busyUntilUs;								/** End of the erase running **/
+	uint32_t	busyAddr;									/** Flash erased by it **/
+	uint32_t	busyLen;									/** Bytes erased by it **/
+	uint32_t	eraseWaitUs;								/** CPU time in erases and busy checks, the stall **/
+	uint32_t	programTimeUs;								/** CPU time in programs **/
+} ymodem_flashsim_t;
+#endif
+
+
+void			ymodem_SinkInit(ymodem_sink_t *sink, const ymodem_sink_ops_t *ops, uint8_t *page, uint32_t pageSize, uint32_t sectorSize);
+void			ymodem_SinkSetRegion(ymodem_sink_t *sink, uint32_t base, uint32_t capacity);
+void			ymodem_SinkSetKeepOnAbort(ymodem_sink_t *sink, uint8_t enable);
+void			ymodem_SinkSetCompare(ymodem_sink_t *sink, uint8_t *sector);
+ymodem_err_e	ymodem_SinkCallback(ymodem_sink_t *sink, ymodem_t *ymodem, ymodem_file_cb_e e, uint8_t *data, uint32_t len);
+ymodem_err_e	ymodem_SinkAbort(ymodem_sink_t *sink);
+ymodem_err_e	ymodem_SinkPoll(ymodem_sink_t *sink);
+#if (YM_RESUME > 0)
+uint32_t		ymodem_SinkResume(ymodem_sink_t *sink, ymodem_t *ymodem, uint32_t committed);
+#endif
+#if (YM_SINK_SIM > 0)
+void			ymodem_FlashSimInit(ymodem_flashsim_t *sim, uint8_t *mem, uint32_t base, uint32_t size, uint32_t pageSize, uint32_t sectorSize);
+void			ymodem_FlashSimSetTiming(ymodem_flashsim_t *sim, uint32_t eraseUs, uint32_t programUs, uint8_t background, uint8_t concurrent);
+void			ymodem_FlashSimOps(ymodem_flashsim_t *sim, ymodem_sink_ops_t *ops);
+#endif
+
+#endif // YMODEM_SINK_H